@@ -5,18 +5,55 @@
 #ifndef GEAR_BEDWRITER_H
 #define GEAR_BEDWRITER_H
 
-#include <fstream>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <bgzf.h>
+#include <hts.h>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace cmri {
 
+    //Buffered bed file writer. With bgzf the file is block compressed (.bed.gz) and a tabix index (.bed.gz.tbi) is
+    //built while writing; records of a chromosome are then kept until the next chromosome and written sorted by start.
     class bedWriter {
 
-        std::ofstream file;
+        struct bed_line_t {
+            int start;
+            int end;
+            std::string line;
+        };
+
+        std::string file_name;
+        bool item_rgb;
+        boost::iostreams::filtering_ostream stream;
+        BGZF *bgzf_file = nullptr;
+        hts_idx_t *index = nullptr;
+        std::map<std::string, int> contig_ids;
+        std::vector<std::string> contigs;
+        std::string current_chromosome;
+        std::vector<bed_line_t> pending;
+        std::string line;
+
+        void write(const std::string &text);
+
+        void flushChromosome();
 
     public:
-        bedWriter(std::string file_name);
 
-        void append(std::string chromosome, int start, int end, std::string _name, int score =0, bool strand=true, int thickStart=0, int thickEnd=0, int r=255, int g=0,int b=0);
+        static const std::streamsize buffer_size = 1 << 20;
+
+        //item_rgb = false drops the itemRgb column (bed8).
+        explicit bedWriter(const std::string &_file_name, bool bgzf = false, bool _item_rgb = true);
+
+        void append(const std::string &chromosome, int start, int end, const std::string &_name, int score = 0,
+                    bool strand = true, int thickStart = 0, int thickEnd = 0, int r = 255, int g = 0, int b = 0);
+
+        inline const std::string &getFileName() const { return file_name; }
+
+        //flush the buffers and save the index, false if the file could not be written.
+        bool close();
 
         virtual ~bedWriter();
 
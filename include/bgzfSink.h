@@ -0,0 +1,53 @@
+#ifndef GEAR_BGZFSINK_H
+#define GEAR_BGZFSINK_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/iostreams/categories.hpp>
+#include <bgzf.h>
+#include <ios>
+
+namespace cmri {
+
+    //boost::iostreams sink writing bgzf (block gzip, readable by any gzip reader and indexable by htslib).
+    //The sink only borrows the file: its owner closes it with bgzf_close once the stream is flushed.
+    class bgzfSink {
+
+        BGZF *file;
+
+    public:
+        typedef char char_type;
+        typedef boost::iostreams::sink_tag category;
+
+        explicit bgzfSink(BGZF *_file) : file(_file) {}
+
+        std::streamsize write(const char *s, std::streamsize n) {
+            if (bgzf_write(file, s, n) < 0) { throw std::ios_base::failure("Unable to write bgzf block"); }
+            return n;
+        }
+
+    };
+
+}
+
+#endif //GEAR_BGZFSINK_H
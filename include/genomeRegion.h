@@ -42,12 +42,9 @@ namespace cmri {
         }
 
 
-        inline bool intersect(const unsigned int other_start, const unsigned int other_end) const {
-            if (start == end) { return true; }
-            double l_other = static_cast<double>(other_start - start) / (end - start);
-            double r_other = static_cast<double>(other_end - start) / (end - start);
-            return l_other >= 0 && r_other <= 1; //fully inside region
-            // any other case is outside.
+        //a read belongs to the region when its end position lies in the region (whole contig if start == end).
+        inline bool intersect(const unsigned int /*other_start*/, const unsigned int other_end) const {
+            return start == end || (start <= other_end && other_end <= end);
         }
 
 
@@ -62,13 +59,18 @@ namespace cmri {
             return !(rhs == *this);
         }
 
-        virtual std::string serialize() const {
-            std::stringstream result;
+        //json object of the region, written into the output stream.
+        virtual void serialize(std::ostream &result) const {
             result << "{";
             result << "\"start\":" << start << ",";
             result << "\"end\":" << end << ",";
             result << "\"name\":\"" << name << "\"";
             result << "}";
+        };
+
+        std::string serialize() const {
+            std::stringstream result;
+            serialize(result);
             return result.str();
         };
 
@@ -89,7 +91,7 @@ namespace cmri {
 
     inline std::ostream& operator<<(std::ostream& result, const genomeRegion& rhs)
     {
-        result << rhs.serialize();
+        rhs.serialize(result);
         return result;
     }
 
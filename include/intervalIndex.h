@@ -0,0 +1,129 @@
+#ifndef GEAR_INTERVALINDEX_H
+#define GEAR_INTERVALINDEX_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace cmri {
+
+    //Static index of closed intervals [start, end] answering which intervals contain a position.
+    //Intervals are sorted by start and seen as an implicit binary tree over the array, each node keeping the largest end
+    //of its subtree (same layout as cgranges), so a query costs O(log n + hits) with integer comparisons only.
+    template<class T>
+    class intervalIndex {
+
+        struct interval_t {
+            int64_t start;
+            int64_t end; //one past the last position
+            int64_t max_end;
+            T value;
+        };
+
+        std::vector<interval_t> intervals;
+        int max_level = -1;
+
+    public:
+
+        inline void add(int64_t start, int64_t end, const T &value) {
+            intervals.push_back({start, end + 1, end + 1, value});
+            max_level = -1;
+        }
+
+        inline size_t size() const { return intervals.size(); }
+
+        inline bool empty() const { return intervals.empty(); }
+
+        //sort and compute the subtree ends, required after the last add.
+        void index() {
+            std::sort(intervals.begin(), intervals.end(),
+                      [](const interval_t &a, const interval_t &b) { return a.start < b.start; });
+            const size_t n = intervals.size();
+            max_level = 0;
+            if (n == 0) { return; }
+            size_t last_i = 0;
+            int64_t last = 0;
+            for (size_t i = 0; i < n; i += 2) {
+                last_i = i;
+                last = intervals[i].max_end = intervals[i].end;
+            }
+            int k;
+            for (k = 1; (static_cast<size_t>(1) << k) <= n; ++k) {
+                size_t x = static_cast<size_t>(1) << (k - 1);
+                size_t i0 = (x << 1) - 1;
+                size_t step = x << 2;
+                for (size_t i = i0; i < n; i += step) {
+                    int64_t left = intervals[i - x].max_end;
+                    int64_t right = i + x < n ? intervals[i + x].max_end : last;
+                    intervals[i].max_end = std::max(intervals[i].end, std::max(left, right));
+                }
+                last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+                if (last_i < n && intervals[last_i].max_end > last) { last = intervals[last_i].max_end; }
+            }
+            max_level = k - 1;
+        }
+
+        //calls f(value) for every interval containing position.
+        template<class F>
+        void find(int64_t position, F f) const {
+            const size_t n = intervals.size();
+            if (n == 0) { return; }
+            const int64_t query_start = position;
+            const int64_t query_end = position + 1;
+
+            struct node_t {
+                int k;
+                size_t x;
+                int w;
+            };
+            node_t stack[64];
+            int top = 0;
+            stack[top++] = {max_level, (static_cast<size_t>(1) << max_level) - 1, 0};
+            while (top > 0) {
+                node_t z = stack[--top];
+                if (z.k <= 3) {
+                    //small subtree, linear scan.
+                    size_t i0 = z.x >> z.k << z.k;
+                    size_t i1 = std::min(i0 + (static_cast<size_t>(1) << (z.k + 1)) - 1, n);
+                    for (size_t i = i0; i < i1 && intervals[i].start < query_end; ++i) {
+                        if (query_start < intervals[i].end) { f(intervals[i].value); }
+                    }
+                } else if (z.w == 0) {
+                    //visit the left child first.
+                    size_t y = z.x - (static_cast<size_t>(1) << (z.k - 1));
+                    stack[top++] = {z.k, z.x, 1};
+                    if (y >= n || intervals[y].max_end > query_start) { stack[top++] = {z.k - 1, y, 0}; }
+                } else if (z.x < n && intervals[z.x].start < query_end) {
+                    if (query_start < intervals[z.x].end) { f(intervals[z.x].value); }
+                    stack[top++] = {z.k - 1, z.x + (static_cast<size_t>(1) << (z.k - 1)), 0};
+                }
+            }
+        }
+
+    };
+
+}
+
+#endif //GEAR_INTERVALINDEX_H
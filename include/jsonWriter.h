@@ -0,0 +1,118 @@
+#ifndef GEAR_JSONWRITER_H
+#define GEAR_JSONWRITER_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include "bgzfSink.h"
+#include "logger.h"
+#include "utils.h"
+#include <string>
+
+namespace cmri {
+
+    //bgzf suits record streams (ndjson): blocks can be indexed and read from the middle of the file.
+    enum class compression_t : int { none, gzip, bgzf };
+
+    //Buffered (optionally gzip compressed) output file for json results. Values are serialized straight into the
+    //buffer with cmri::serialize(std::ostream&, value), the document is never built in memory.
+    class jsonWriter {
+
+        std::string file_name;
+        boost::iostreams::filtering_ostream stream;
+        BGZF *bgzf_file = nullptr;
+
+        void open(compression_t compression) {
+            if (compression == compression_t::bgzf) {
+                bgzf_file = bgzf_open(file_name.c_str(), "w");
+                if (bgzf_file == nullptr) {
+                    LOGGER.error << "Unable to write output file: " << file_name << std::endl;
+                    exit(EIO);
+                }
+                stream.push(bgzfSink(bgzf_file), buffer_size);
+                return;
+            }
+            boost::iostreams::file_sink file(file_name, std::ios_base::out | std::ios_base::binary);
+            if (!file.is_open()) {
+                LOGGER.error << "Unable to write output file: " << file_name << std::endl;
+                exit(EIO);
+            }
+            if (compression == compression_t::gzip) { stream.push(boost::iostreams::gzip_compressor(), buffer_size); }
+            stream.push(file, buffer_size);
+        }
+
+    public:
+
+        static const std::streamsize buffer_size = 1 << 20;
+
+        //compressed files get .gz added to their name.
+        jsonWriter(const std::string &_file_name, compression_t compression) :
+                file_name(compression == compression_t::none ? _file_name : _file_name + ".gz") {
+            open(compression);
+        }
+
+        jsonWriter(const std::string &_file_name, bool gzip) :
+                jsonWriter(_file_name, gzip ? compression_t::gzip : compression_t::none) {}
+
+        ~jsonWriter() { close(); }
+
+        template<class T>
+        inline jsonWriter &write(const T &value) {
+            serialize(stream, value);
+            return *this;
+        }
+
+        //one value per line (ndjson).
+        template<class T>
+        inline jsonWriter &writeLine(const T &value) {
+            serialize(stream, value);
+            stream << '\n';
+            return *this;
+        }
+
+        //for callers writing the document piece by piece.
+        inline std::ostream &get() { return stream; }
+
+        inline const std::string &getFileName() const { return file_name; }
+
+        //flush the buffers (and the gzip trailer), false if the file could not be written.
+        bool close() {
+            if (stream.empty()) { return true; }
+            stream.flush();
+            bool good = stream.good();
+            stream.reset();
+            if (bgzf_file != nullptr) {
+                good = bgzf_close(bgzf_file) == 0 && good;
+                bgzf_file = nullptr;
+            }
+            if (!good) { LOGGER.error << "Unable to write output file: " << file_name << std::endl; }
+            return good;
+        }
+
+    };
+
+}
+
+#endif //GEAR_JSONWRITER_H
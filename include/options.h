@@ -25,6 +25,7 @@
 
 #include <string>
 #include <thread>
+#include <vector>
 #include "utils.h"
 
 namespace cmri {
@@ -35,7 +36,7 @@ namespace cmri {
 
     /// Defines an enumerator for the tasks
     enum class task_t : int {
-        MotifCount=1, VariantCallAnalysis, GenomeAnalysis, IwgsAnalysis, TelomereMutations, RandomSelector, QVSelector
+        MotifCount=1, VariantCallAnalysis, GenomeAnalysis, IwgsAnalysis, TelomereMutations, RandomSelector, QVSelector, Merge
     };
 
     /// Map a string argument to a task enumerator.
@@ -47,6 +48,7 @@ namespace cmri {
             , {"TelomereMutations",task_t::TelomereMutations}
             , {"RandomSelector",task_t::RandomSelector}
             , {"QVSelector",task_t::QVSelector}
+            , {"Merge",task_t::Merge}
     };
 
     struct common_options_t {
@@ -60,11 +62,22 @@ namespace cmri {
         int progress = 0;
         int chunk_size = 1;
         int threads = 1;
+        bool resume = false; //continue from the checkpoint in output_path
+        bool partial = false; //also write the results as output.partial, see merge_options_t
+        bool gzip_output = false; //output.json.gz instead of output.json, bgzipped ndjson and bed files
+        int shard_count = 1; //input split in byte ranges read by independent runs, see sequenceReader::setShard
+        int shard_index = 0;
 
         void validate() {
             int max_threads = static_cast<int>(std::thread::hardware_concurrency());
             threads = cmri::clip(threads, 1, max_threads);
             progress = std::max(progress, 0);
+            shard_count = std::max(shard_count, 1);
+            if (shard_index < 0 || shard_index >= shard_count) {
+                LOGGER.error << "Invalid argument. common.shard_index must be between 0 and common.shard_count - 1."
+                             << std::endl;
+                exit(EINVAL);
+            }
             //test if files exists.
             cmri::open_file(input_file, "expecting input file").close();
         }
@@ -76,11 +89,23 @@ namespace cmri {
         int quality_value = 0;
         int quality_map = 0;
         bool validate_sequence;
+        bool quality_histogram = true;
+        bool indexed = false;
+        bool unmapped = true;
+        std::string partition = "none"; //none, contig or tile
+        int tile_size = 10000000;
+        int checkpoint = 0; //reads between checkpoints, 0 - off
 
         void validate() {
             cmri::open_file(motif_file, "expecting motif file");
             quality_value = cmri::clip(quality_value, 0, 92);
             quality_map = cmri::clip(quality_map, 0, 254);
+            if (partition != "none" && partition != "contig" && partition != "tile") {
+                LOGGER.error << "Invalid argument. motif_count.partition must be none, contig or tile." << std::endl;
+                exit(EINVAL);
+            }
+            tile_size = std::max(tile_size, 1000);
+            checkpoint = std::max(checkpoint, 0);
         }
 
     };
@@ -126,6 +151,19 @@ namespace cmri {
     };
 
 
+    struct merge_options_t {
+        std::vector<std::string> partials; //output.partial files of runs of the same task
+
+        void validate() const {
+            if (partials.empty()) {
+                LOGGER.error << "Invalid argument. Merge expects at least one merge.partials file." << std::endl;
+                exit(EINVAL);
+            }
+            for (auto &partial : partials) { cmri::open_file(partial, "expecting partial result file.").close(); }
+        }
+    };
+
+
     struct telomere_mutations_options_t {
 
         std::string target_file;
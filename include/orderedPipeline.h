@@ -0,0 +1,130 @@
+#ifndef GEAR_ORDEREDPIPELINE_H
+#define GEAR_ORDEREDPIPELINE_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cmri {
+
+    //Maps the items returned by next on threads workers and passes the results to write in input order.
+    //  next(R &item): false at the end of the input, called from a single reader thread.
+    //  map(int worker, const R &item, T &result): false if the item has no result (nothing is written for it).
+    //  write(T &result): runs on the calling thread, so it may log or use non thread safe outputs.
+    //Results finished out of order wait in a reorder buffer. The reader never holds more than max_pending items that
+    //are not written yet, so memory does not grow with the input. Returns the number of items read.
+    template<class R, class T, class N, class M, class W>
+    uint64_t orderedPipeline(int threads, uint64_t max_pending, N next, M map, W write) {
+
+        if (threads <= 1) {
+            uint64_t count = 0;
+            R item;
+            while (next(item)) {
+                count++;
+                T result;
+                if (map(0, item, result)) { write(result); }
+            }
+            return count;
+        }
+
+        max_pending = std::max<uint64_t>(max_pending, 1);
+        std::mutex mutex;
+        std::condition_variable item_ready, item_mapped, slot_free;
+        std::deque<std::pair<uint64_t, R>> items;
+        std::map<uint64_t, std::unique_ptr<T>> mapped; //null for items without result
+        uint64_t items_read = 0;
+        uint64_t items_written = 0;
+        bool reading_done = false;
+
+        std::thread reader([&]() {
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    slot_free.wait(lock, [&]() { return items_read - items_written < max_pending; });
+                }
+                R item;
+                if (!next(item)) { break; }
+                std::lock_guard<std::mutex> lock(mutex);
+                items.emplace_back(items_read++, std::move(item));
+                item_ready.notify_one();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            reading_done = true;
+            item_ready.notify_all();
+            item_mapped.notify_all();
+        });
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                while (true) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    item_ready.wait(lock, [&]() { return !items.empty() || reading_done; });
+                    if (items.empty()) { break; }
+                    auto item = std::move(items.front());
+                    items.pop_front();
+                    lock.unlock();
+
+                    std::unique_ptr<T> result(new T());
+                    if (!map(t, item.second, *result)) { result.reset(); }
+
+                    lock.lock();
+                    mapped[item.first] = std::move(result);
+                    item_mapped.notify_one();
+                }
+            });
+        }
+
+        //each result is written as soon as the ones before it are, its slot is freed once it is written.
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            item_mapped.wait(lock, [&]() {
+                return mapped.count(items_written) > 0 || (reading_done && items_written == items_read);
+            });
+            auto found = mapped.find(items_written);
+            if (found == mapped.end()) { break; }
+            auto result = std::move(found->second);
+            mapped.erase(found);
+            lock.unlock();
+            if (result) { write(*result); }
+            lock.lock();
+            items_written++;
+            slot_free.notify_one();
+        }
+
+        reader.join();
+        for (auto &worker : workers) { worker.join(); }
+        return items_read;
+    }
+
+}
+
+#endif //GEAR_ORDEREDPIPELINE_H
@@ -0,0 +1,171 @@
+#ifndef GEAR_PARTIALRESULT_H
+#define GEAR_PARTIALRESULT_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cmri {
+
+    //Binary values of checkpoints and partial results: plain values in host byte order, strings and containers
+    //prefixed by their size. They are read back by the same build (nodes of one cluster), not exchanged.
+    template<class T>
+    inline void writeBinary(std::ostream &out, const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "plain values only");
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    inline bool readBinary(std::istream &in, T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "plain values only");
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    inline void writeBinary(std::ostream &out, const std::string &value) {
+        writeBinary(out, static_cast<uint64_t>(value.size()));
+        out.write(value.data(), value.size());
+    }
+
+    inline bool readBinary(std::istream &in, std::string &value) {
+        uint64_t size;
+        if (!readBinary(in, size) || size > (1u << 24)) { return false; }
+        value.resize(size);
+        return size == 0 || static_cast<bool>(in.read(&value[0], size));
+    }
+
+    template<class T>
+    inline void writeBinary(std::ostream &out, const std::vector<T> &values);
+
+    template<class T>
+    inline bool readBinary(std::istream &in, std::vector<T> &values);
+
+    template<class K, class V>
+    inline void writeBinary(std::ostream &out, const std::map<K, V> &values) {
+        writeBinary(out, static_cast<uint64_t>(values.size()));
+        for (auto &item : values) {
+            writeBinary(out, item.first);
+            writeBinary(out, item.second);
+        }
+    }
+
+    template<class K, class V>
+    inline bool readBinary(std::istream &in, std::map<K, V> &values) {
+        uint64_t size;
+        if (!readBinary(in, size)) { return false; }
+        values.clear();
+        for (uint64_t i = 0; i < size; i++) {
+            K key;
+            if (!readBinary(in, key) || !readBinary(in, values[key])) { return false; }
+        }
+        return true;
+    }
+
+    template<class T>
+    inline void writeBinary(std::ostream &out, const std::vector<T> &values) {
+        writeBinary(out, static_cast<uint64_t>(values.size()));
+        for (auto &value : values) { writeBinary(out, value); }
+    }
+
+    template<class T>
+    inline bool readBinary(std::istream &in, std::vector<T> &values) {
+        uint64_t size;
+        if (!readBinary(in, size) || size > (1u << 28)) { return false; }
+        values.resize(size);
+        for (auto &value : values) {
+            if (!readBinary(in, value)) { return false; }
+        }
+        return true;
+    }
+
+
+    //Task whose result map a partial file holds.
+    enum class partial_t : uint32_t { motif = 1, variant, telomere };
+
+    static const char partial_magic[] = "GEARPRT1";
+
+    //Result map of a task in binary form, for the Merge task: every region with its definition (position, patterns)
+    //and counts, written by the region writePartial.
+    template<class R>
+    bool writePartial(const std::string &file_name, partial_t kind, const std::map<std::string, std::vector<R>> &regions) {
+        std::ofstream file(file_name, std::ios::binary);
+        file.write(partial_magic, sizeof(partial_magic) - 1);
+        writeBinary(file, kind);
+        writeBinary(file, static_cast<uint64_t>(regions.size()));
+        for (auto &item : regions) {
+            writeBinary(file, item.first);
+            writeBinary(file, static_cast<uint64_t>(item.second.size()));
+            for (auto &region : item.second) { region.writePartial(file); }
+        }
+        file.close();
+        return static_cast<bool>(file);
+    }
+
+    //header of a partial file, false if it is not one.
+    inline bool readPartialKind(std::istream &in, partial_t &kind) {
+        std::string magic(sizeof(partial_magic) - 1, ' ');
+        return in.read(&magic[0], magic.size()) && magic == partial_magic && readBinary(in, kind);
+    }
+
+    //add the regions of a partial (after its header) to a result map. Keys missing in the map are inserted, the
+    //regions of a key found in both must be the same (position and patterns) and their counts are added.
+    //False on a damaged file or different regions.
+    template<class R>
+    bool mergePartial(std::istream &in, std::map<std::string, std::vector<R>> &regions) {
+        uint64_t keys;
+        if (!readBinary(in, keys)) { return false; }
+        for (uint64_t k = 0; k < keys; k++) {
+            std::string key;
+            uint64_t size;
+            if (!readBinary(in, key) || !readBinary(in, size)) { return false; }
+            std::vector<R> partial(size);
+            for (auto &region : partial) {
+                if (!region.readPartial(in)) { return false; }
+            }
+
+            auto found = regions.find(key);
+            if (found == regions.end()) {
+                regions[key] = std::move(partial);
+                continue;
+            }
+            if (found->second.size() != partial.size()) { return false; }
+            try {
+                for (size_t i = 0; i < partial.size(); i++) { found->second[i] += partial[i]; }
+            }
+            catch (std::runtime_error &) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
+#endif //GEAR_PARTIALRESULT_H
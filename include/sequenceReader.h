@@ -29,6 +29,9 @@
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include "kseq.h"
 #include <sam.h>
+#include <thread_pool.h>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <zlib.h>
 
@@ -42,14 +45,72 @@ namespace cmri {
     struct read_item_t {
 
         std::string sequence;
-        std::vector<int> qvalue;
+        std::string raw_quality; //quality bytes as stored in the file, phred + quality_offset
+        uint8_t quality_offset = 0; //33 for fastq, 0 for bam
+        std::vector<uint8_t> qvalue; //phred values, one byte per base, filled by decodeQuality
+        std::vector<uint32_t> qsum; //prefix sums of qvalue, qsum[i] = qvalue[0] + ... + qvalue[i - 1] (empty without qvalue)
         unsigned int start = 0;
         unsigned int end = 0;
         std::string name;
+        int32_t tid = -1; //bam contig id when name is the contig (not unmapped, qv_fail or mapq_fail)
         bool valid = true;
 
         void clear();
 
+        //fill qvalue and qsum from raw_quality. The reader calls it unless quality decoding is off.
+        void decodeQuality();
+
+    };
+
+    //prefix sums of phred values: sum has quality.size() + 1 entries, the mean over [start, start + n) is
+    //(sum[start + n] - sum[start]) / n for any hit, whatever its length.
+    inline void qualityPrefixSum(const std::vector<uint8_t> &quality, std::vector<uint32_t> &sum) {
+        sum.resize(quality.size() + 1);
+        sum[0] = 0;
+        for (size_t i = 0; i < quality.size(); i++) { sum[i + 1] = sum[i] + quality[i]; }
+    }
+
+    //Fixed number of read slots filled by sequenceReader::get(read_batch_t&).
+    //Slots are overwritten in place, their sequence and quality buffers keep the capacity of the longest read seen,
+    //so refilling a recycled batch does not touch the heap.
+    struct read_batch_t {
+
+        std::vector<read_item_t> items;
+        size_t size = 0; //filled slots
+
+        explicit read_batch_t(size_t capacity) : items(capacity) {}
+
+        inline size_t capacity() const { return items.size(); }
+        inline bool empty() const { return size == 0; }
+        inline void clear() { size = 0; }
+
+        inline std::vector<read_item_t>::const_iterator begin() const { return items.begin(); }
+        inline std::vector<read_item_t>::const_iterator end() const { return items.begin() + size; }
+
+    };
+
+    //Owns the read batches handed between the reader and the workers.
+    //Released batches are returned by the next acquire, new batches are only created when none is free.
+    //Batches are handed out as raw pointers so they can travel through the batch queues; they live as long as the pool.
+    class readBatchPool {
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<read_batch_t>> batches;
+        std::vector<read_batch_t *> free_batches;
+        size_t batch_size;
+
+    public:
+        explicit readBatchPool(size_t _batch_size) : batch_size(_batch_size) {}
+
+        read_batch_t *acquire();
+
+        void release(read_batch_t *batch);
+
+        inline size_t size() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return batches.size();
+        }
+
     };
 
 
@@ -65,41 +126,112 @@ namespace cmri {
         boost::iostreams::filtering_streambuf<boost::iostreams::input> inbuf;
 
         //Sam/Bam file handler
-        samFile *bam_file;
-        bam_hdr_t *bam_header; //read header
+        samFile *bam_file = nullptr;
+        bam_hdr_t *bam_header = nullptr; //read header
         bam1_t *alignment; //initialize an alignment
+        htsThreadPool thread_pool = {nullptr, 0}; //BGZF decompression workers
+        hts_idx_t *bam_index = nullptr; //region queries
+        hts_itr_t *bam_iterator = nullptr;
+        bool unmapped_tail = false;
+        int32_t partition_tid = -1; //setPartition
+        int64_t partition_begin = 0;
+        int64_t shard_end = -1; //setShard: bgzf block (bam) or uncompressed offset (fasta/fastq) the shard ends at
+        int64_t range_begin = 0; //bytes of the input file read by this reader, for the progress
+        int64_t range_end = 0;
 
         bool (sequenceReader::*getItem)(read_item_t &item);
         void (sequenceReader::*closeFile)();
+        int64_t (sequenceReader::*fileOffset)(); //bytes of the input file consumed so far (compressed for gzip/bgzf)
 
         bool getFastxItem(read_item_t &item);
+        bool getFastxShardItem(read_item_t &item);
+        void setFastxShard(int index, int shard_count);
         void closeFastxFile();
+        int64_t fastxFileOffset();
 
         bool getCsvItem(read_item_t &item);
         void closeCsvFile();
+        int64_t csvFileOffset();
 
         bool getBamItem(read_item_t &item);
+        bool getBamRegionItem(read_item_t &item);
+        bool getBamPartitionItem(read_item_t &item);
+        bool getBamShardItem(read_item_t &item);
+        void setBamShard(int index, int shard_count);
+        void loadBamIndex();
+        void decodeBamItem(read_item_t &item);
         void closeBamFile();
+        int64_t bamFileOffset();
+
+        //mean phred value of the read, decodes its qualities when decode_quality is set.
+        double meanQuality(read_item_t &item);
 
+        std::string file_name;
+        int64_t file_size;
         int count;
         int quality_value;
         int quality_map;
-        int total_reads;
+        int total_reads = -1; //counted on request
+        int threads;
+        bool decode_quality = true;
 
     public:
-        sequenceReader(std::string input_file, int _quality_value, int _quality_map);
+        sequenceReader(std::string input_file, int _quality_value, int _quality_map, int _threads = 1);
 
         ~sequenceReader() = default;
 
         inline bool get(read_item_t &item) {return (this->*getItem)(item);}
+
+        //Fill the batch with up to batch.capacity() valid reads, returns the number of reads (0 at the end of the input).
+        size_t get(read_batch_t &batch);
+
         inline void close() {(this->*closeFile)();}
 
+        //When off, reads only carry their raw quality bytes (qvalue and qsum stay empty) and the mean quality is
+        //only computed for the quality_value threshold. For callers that do not use per base qualities.
+        inline void setQualityDecoding(bool decode) { decode_quality = decode; }
+
+        //Contig names of the bam header indexed by tid, empty for other formats.
+        std::vector<std::string> getContigNames() const;
+
+        //Contig lengths of the bam header indexed by tid, empty for other formats.
+        std::vector<int64_t> getContigLengths() const;
+
+        //Restrict an indexed bam to the given regions (samtools syntax), optionally followed by the unmapped reads.
+        bool setRegions(const std::vector<std::string> &regions, bool unmapped);
+
+        //Restrict an indexed bam to the reads whose alignment starts in [begin, end) of contig tid, or to the reads
+        //without coordinates if tid < 0. Partitions that tile the genome return every read exactly once.
+        //It can be called again to move the reader to another partition, the index is loaded once.
+        bool setPartition(int32_t tid, int64_t begin, int64_t end);
+
+        //Restrict the input to shard index of shard_count (0 <= index < shard_count) without reading the rest of the
+        //file, so independent processes can split one input. Shards are byte ranges of the file: whole bgzf blocks for
+        //bam and bgzipped fasta/fastq, plain offsets for uncompressed fasta/fastq. A read belongs to the shard where it
+        //starts (where the line before it ends for fasta/fastq), so the shards of a file return every read exactly
+        //once. Call it before reading. Csv and plain gzip inputs cannot be split (error).
+        void setShard(int index, int shard_count);
+
         inline int getCount() const {
             return count;
         }
-        inline int getTotalReads() const {
-            return total_reads;
-        }
+
+        //Number of records in the input. Indexed bam files use the index statistics, any other input is read once
+        //more to count them, so call it only when the total is really needed.
+        int getTotalReads();
+
+        //Fraction of the input file (or shard) consumed, from the (compressed) byte offset.
+        double getProgress();
+
+        inline int64_t getFileSize() const { return file_size; }
+
+        //Position of the next read, for seek: bgzf virtual offset for bam, uncompressed offset for fasta/fastq
+        //(plain or gzip, from the start of the shard). -1 for csv input and region or partition queries, which cannot
+        //be resumed.
+        int64_t tell();
+
+        //Continue reading at a position returned by tell, count is the number of reads before it.
+        bool seek(int64_t position, int _count);
 
 
 
@@ -166,7 +166,18 @@ namespace cmri {
         return std::max(lower, std::min(n, upper));
     }
 
-    inline void create_output_directory(std::string path, bool backup) {
+    //keep: leave an existing directory as it is (resumed runs).
+    inline void create_output_directory(std::string path, bool backup, bool keep = false) {
+
+        //resumed runs keep the output directory (and its checkpoint).
+        if (keep) {
+            std::string mkdir = "mkdir -p " + path;
+            int sys_out = system(mkdir.c_str());
+            if (sys_out) {
+                LOGGER.debug << "mkdir -p return value " << sys_out << std::endl;
+            }
+            return;
+        }
 
         int sys_out;
         if (backup) {
@@ -214,12 +225,12 @@ namespace cmri {
 
     }
 
+    //reads in a bam file taken from the index statistics (mapped, unmapped and reads without coordinates),
+    //-1 when the file has no index.
     inline int get_total_reads(samFile *bam_file, bam_hdr_t *bam_header ){
 
-        std::string index_file_name = bam_file->fn;
-        index_file_name += ".bai";
-        open_file(index_file_name,"expecting bam index").close(); // check if file exists
-        auto bam_index = sam_index_load(bam_file, index_file_name.c_str());
+        auto bam_index = sam_index_load3(bam_file, bam_file->fn, nullptr, HTS_IDX_SILENT_FAIL);
+        if (bam_index == nullptr) { return -1; }
         auto n_targets = bam_header->n_targets;
         int result = 0;
         for (int tid = 0; tid < n_targets; tid++) {
@@ -229,11 +240,14 @@ namespace cmri {
                 result += static_cast<int>(mapped + unmapped);
             }
         }
+        result += static_cast<int>(hts_idx_get_n_no_coor(bam_index));
 
         hts_idx_destroy(bam_index);
         return result;
     }
 
+    //Number of records in the file. Except for indexed bam files the whole file is read (and inflated), use only when
+    //the total is really needed.
     inline int count_reads(const std::string &file_name) {
 
         int result = 0;
@@ -241,13 +255,24 @@ namespace cmri {
 
         char token = (format&format_t::FASTA)  ? '>' :'\n';
         int factor = (format&format_t::FASTQ ) ? 4 : 1;
+        int header = (format&format_t::CSV ) ? 1 : 0;
 
         if(format == BAM) {
             samFile *bam_file = hts_open(file_name.c_str(), "r");
+            if (bam_file == nullptr) { return result; }
             bam_hdr_t *bam_header = sam_hdr_read(bam_file); //read header
-            return get_total_reads(bam_file, bam_header);
+            result = get_total_reads(bam_file, bam_header);
+            if (result < 0) {
+                result = 0;
+                bam1_t *alignment = bam_init1();
+                while (sam_read1(bam_file, bam_header, alignment) >= 0) { result++; }
+                bam_destroy1(alignment);
+            }
+            bam_hdr_destroy(bam_header);
+            sam_close(bam_file);
+            return result;
         }
-        if( format&format_t::GZIP&(format_t::FASTA|format_t::FASTQ|format_t::CSV) ){
+        if( (format&format_t::GZIP) && (format&(format_t::FASTA|format_t::FASTQ|format_t::CSV)) ){
 
             std::ifstream file(file_name, std::ios_base::in | std::ios_base::binary);
             boost::iostreams::filtering_streambuf<boost::iostreams::input> inbuf;
@@ -255,47 +280,55 @@ namespace cmri {
             inbuf.push(file);
             //Convert streambuf to istream
             std::istream instream(&inbuf);
-            return std::count(std::istreambuf_iterator<char>(instream), std::istreambuf_iterator<char>(), token)/factor;
+            return std::count(std::istreambuf_iterator<char>(instream), std::istreambuf_iterator<char>(), token)/factor - header;
         }
         if (format & (format_t::FASTA | format_t::FASTQ | format_t::CSV)) {
             std::ifstream file(file_name);
             return std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), token) /
-                   factor;
+                   factor - header;
         }
         return result;
     }
 
+    //Json output is written straight into a stream (see jsonWriter), values are never built as strings first.
     template<class T>
-    inline std::string serialize(const T &item) {
-        std::stringstream sample_data;
-        sample_data << item;
-        return sample_data.str();
+    inline void serialize(std::ostream &result, const T &item) {
+        result << item;
     };
 
+    template<class T>
+    void serialize(std::ostream &result, const std::vector<T> &vector_data);
+
+    template<class S, class T>
+    void serialize(std::ostream &result, const std::map<S,T> &map_data);
 
     template<class T>
-    std::string serialize(const std::vector<T> &vector_data) {
-        std::stringstream result;
+    void serialize(std::ostream &result, const std::vector<T> &vector_data) {
         result << "[";
-        int list_size= vector_data.size();
-        for(int i=0; i < list_size; i++){
-            result << serialize(vector_data[i]) << (i<list_size-1 ? "," :"");
+        size_t list_size= vector_data.size();
+        for(size_t i=0; i < list_size; i++){
+            serialize(result, vector_data[i]);
+            result << (i<list_size-1 ? "," :"");
         }
         result << "]";
-        return result.str();
     };
 
     template<class S, class T>
-    std::string serialize(const std::map<S,T> &map_data) {
-        std::stringstream result;
+    void serialize(std::ostream &result, const std::map<S,T> &map_data) {
         result << "{";
         for(auto iter_data = map_data.begin(); iter_data != map_data.end(); ++iter_data){
             result << "\"" << iter_data->first << "\":";
-            result << serialize(iter_data->second);
+            serialize(result, iter_data->second);
             result << (std::next(iter_data) != map_data.end() ? "," : "");
         }
         result << "}";
+    };
 
+    //the json of a value as a string, for small values and logs.
+    template<class T>
+    inline std::string serialize(const T &item) {
+        std::stringstream result;
+        serialize(result, item);
         return result.str();
     };
 
@@ -332,16 +365,24 @@ namespace cmri {
     }
 
 
-    inline std::string escape_json(const std::string &s) {
-        std::ostringstream o;
+    inline void escape_json(std::ostream &o, const std::string &s) {
         for (auto c = s.cbegin(); c != s.cend(); c++) {
             if (*c == '"' || *c == '\\' || ('\x00' <= *c && *c <= '\x1f')) {
+                auto flags = o.flags();
+                auto fill = o.fill('0');
                 o << "\\u"
-                  << std::hex << std::setw(4) << std::setfill('0') << (int)*c;
+                  << std::hex << std::setw(4) << (int)*c;
+                o.flags(flags);
+                o.fill(fill);
             } else {
                 o << *c;
             }
         }
+    }
+
+    inline std::string escape_json(const std::string &s) {
+        std::ostringstream o;
+        escape_json(o, s);
         return o.str();
     }
 
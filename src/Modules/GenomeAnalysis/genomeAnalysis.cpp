@@ -27,6 +27,7 @@
 #include <bedWriter.h>
 #include "genomeAnalysis.h"
 #include "telomereRegion.h"
+#include "jsonWriter.h"
 #include <math.h>
 
 void cmri::mainGenomeAnalysis(const common_options_t &common_options,
@@ -51,7 +52,9 @@ void cmri::mainGenomeAnalysis(const common_options_t &common_options,
 
     faidx_t *ref_file_index = fai_load(common_options.input_file.c_str());
 
-    bedWriter bed_writer(common_options.output_path + "/output.bed");
+    //gzip_output: bgzipped and tabix indexed bed files.
+    bedWriter bed_writer(common_options.output_path + "/output.bed", common_options.gzip_output);
+    bedWriter telomere_writer(common_options.output_path + "/output_t.bed", common_options.gzip_output, false);
 
 
     for (auto &chromosome_item : regions) {
@@ -141,28 +144,25 @@ void cmri::mainGenomeAnalysis(const common_options_t &common_options,
 
             auto bed_regions = ga.process(sequence, chromosome);
 
-            std::ofstream file(common_options.output_path + "/output_t.bed", std::ofstream::app);
             for (auto &item : bed_regions) {
-                file << item.chrom << "\t"
-                     << item.chromStart << "\t"
-                     << item.chromEnd << "\t"
-                     << item.name << "\t"
-                     << item.score << "\t"
-                     << item.strand << "\t"
-                     << item.thickStart << "\t"
-                     << item.thickEnd // << "\t"
-                     << std::endl;
+                telomere_writer.append(item.chrom, item.chromStart, item.chromEnd, item.name, item.score,
+                                       item.strand == '+', item.thickStart, item.thickEnd);
             }
-            file.close();
 
 
         }
     }
 
 
-    std::ofstream file(common_options.output_path + "/output.json");
-    file << cmri::serialize(regions);
-    file.close();
+    bed_writer.close();
+    telomere_writer.close();
+
+    cmri::jsonWriter output(common_options.output_path + "/output.json", common_options.gzip_output);
+    output.write(regions);
+    output.close();
+    if (common_options.partial) {
+        cmri::writePartial(common_options.output_path + "/output.partial", partial_t::telomere, regions);
+    }
 
 
 }
@@ -4,27 +4,27 @@
 
 #include "telomereRegion.h"
 
-std::string cmri::telomere_signature_t::serialize() const {
-    std::stringstream result;
+void cmri::telomere_signature_t::serialize(std::ostream &result) const {
     result << "{";
     result << "\"count\":" << count;
     result << ",\"histogram\":{";
 
     for(auto iter_data = histogram.begin(); iter_data != histogram.end(); ++iter_data) {
-        result << "\"" << iter_data->first <<"\" : " << cmri::serialize(iter_data->second);
+        result << "\"" << iter_data->first <<"\" : ";
+        cmri::serialize(result, iter_data->second);
         result << (std::next(iter_data) != histogram.end() ? "," : "");
     }
     result << "}";
 
     result << ",\"context\":{";
     for(auto iter_data = context.begin(); iter_data != context.end(); ++iter_data) {
-        result << "\"" << iter_data->first <<"\" : " << cmri::serialize(iter_data->second);
+        result << "\"" << iter_data->first <<"\" : ";
+        cmri::serialize(result, iter_data->second);
         result << (std::next(iter_data) != context.end() ? "," : "");
     }
     result << "}";
 
     result << "}";
-    return result.str();
 }
 
 
@@ -55,16 +55,15 @@ void cmri::telomere_signature_t::deserialize(const boost::property_tree::ptree &
 
 
 
-std::string cmri::telomereRegion::serialize() const {
-    std::stringstream result;
+void cmri::telomereRegion::serialize(std::ostream &result) const {
     result << "{";
     result << "\"start\":" << start;
     result << ",\"end\":" << end;
     result << ",\"name\":\"" << name << "\"";
     result << ",\"total_bases\":" << total_bases;
-    result << ",\"variants\":" << cmri::serialize(variants);
+    result << ",\"variants\":";
+    cmri::serialize(result, variants);
     result << "}";
-    return result.str();
 }
 
 void cmri::telomereRegion::deserialize(const boost::property_tree::ptree &tree) {
@@ -88,4 +87,18 @@ void cmri::telomereRegion::deserialize(const boost::property_tree::ptree &tree)
         LOGGER.error << "Exception parsing json file: " << e.what() << std::endl;
         exit(EIO);
     }
-}
\ No newline at end of file
+}
+
+
+void cmri::telomereRegion::writePartial(std::ostream &out) const {
+    writeBinary(out, start);
+    writeBinary(out, end);
+    writeBinary(out, name);
+    writeBinary(out, total_bases);
+    writeBinary(out, variants);
+}
+
+bool cmri::telomereRegion::readPartial(std::istream &in) {
+    return readBinary(in, start) && readBinary(in, end) && readBinary(in, name) && readBinary(in, total_bases) &&
+           readBinary(in, variants);
+}
@@ -6,22 +6,40 @@
 #define GEAR_TELOMEREREGION_H
 
 #include <genomeRegion.h>
+#include "partialResult.h"
 
 namespace cmri {
 
     struct telomere_signature_t {
-        unsigned int count;
+        unsigned int count = 0;
         std::map<unsigned int,unsigned int> histogram;
         std::map<std::string, unsigned int> context;
 
-        std::string serialize() const;
+        void serialize(std::ostream &result) const;
         void deserialize(const boost::property_tree::ptree &tree);
 
+        inline void operator+=(const telomere_signature_t &rhs) {
+            count += rhs.count;
+            for (auto &item : rhs.histogram) { histogram[item.first] += item.second; }
+            for (auto &item : rhs.context) { context[item.first] += item.second; }
+        }
+
     };
 
+    inline void writeBinary(std::ostream &out, const telomere_signature_t &signature) {
+        writeBinary(out, signature.count);
+        writeBinary(out, signature.histogram);
+        writeBinary(out, signature.context);
+    }
+
+    inline bool readBinary(std::istream &in, telomere_signature_t &signature) {
+        return readBinary(in, signature.count) && readBinary(in, signature.histogram) &&
+               readBinary(in, signature.context);
+    }
+
     inline std::ostream& operator<<(std::ostream& result, const telomere_signature_t& rhs)
     {
-        result << rhs.serialize();
+        rhs.serialize(result);
         return result;
     }
 
@@ -32,9 +50,15 @@ namespace cmri {
 
             std::map<std::string,telomere_signature_t> variants;
 
-            std::string serialize() const override;
+            using genomeRegion::serialize;
+            void serialize(std::ostream &result) const override;
             void deserialize(const boost::property_tree::ptree &tree) override;
 
+            //region and counts in binary form (partial results, see the Merge task).
+            void writePartial(std::ostream &out) const;
+
+            bool readPartial(std::istream &in);
+
 
             virtual bool operator==(const telomereRegion &rhs) const {
                 return genomeRegion::operator==(rhs) &&
@@ -42,12 +66,21 @@ namespace cmri {
                         ;
             }
 
+            void operator+=(const telomereRegion &rhs) {
+                if (genomeRegion::operator==(rhs)) {
+                    total_bases += rhs.total_bases;
+                    for (auto &item : rhs.variants) { variants[item.first] += item.second; }
+                } else {
+                    throw std::runtime_error("error regions are not match ");
+                }
+            }
+
 
         };
 
         inline std::ostream& operator<<(std::ostream& result, const telomereRegion& rhs)
         {
-            result << rhs.serialize();
+            rhs.serialize(result);
             return result;
         }
 
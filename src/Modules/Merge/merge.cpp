@@ -0,0 +1,99 @@
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+
+#include "merge.h"
+#include "../MotifCount/motifRegion.h"
+#include "../VariantCallAnalysis/variantRegion.h"
+#include "../GenomeAnalysis/telomereRegion.h"
+#include "jsonWriter.h"
+
+
+namespace {
+
+    template<class R>
+    void mergeFiles(const cmri::common_options_t &common_options, const std::vector<std::string> &partials,
+                    cmri::partial_t kind) {
+
+        std::map<std::string, std::vector<R>> regions;
+        for (auto &file_name : partials) {
+            std::ifstream file(file_name, std::ios::binary);
+            cmri::partial_t file_kind;
+            if (!cmri::readPartialKind(file, file_kind) || file_kind != kind) {
+                cmri::LOGGER.error << "From: " << __FILE__ << ":" << __LINE__ << std::endl;
+                cmri::LOGGER.error << "Invalid argument. Not a partial result of the same task: " << file_name
+                                   << std::endl;
+                exit(EINVAL);
+            }
+            if (!cmri::mergePartial(file, regions)) {
+                cmri::LOGGER.error << "From: " << __FILE__ << ":" << __LINE__ << std::endl;
+                cmri::LOGGER.error << "Damaged partial result or regions that do not match: " << file_name
+                                   << std::endl;
+                exit(EIO);
+            }
+            cmri::LOGGER.info << "Merged: " << file_name << std::endl;
+        }
+
+        cmri::jsonWriter output(common_options.output_path + "/output.json", common_options.gzip_output);
+        output.write(regions);
+        output.close();
+
+        if (common_options.partial) {
+            cmri::writePartial(common_options.output_path + "/output.partial", kind, regions);
+        }
+    }
+
+}
+
+
+void cmri::mainMerge(const common_options_t &common_options, const merge_options_t &merge_options) {
+
+    //the first file tells the task, mergeFiles checks it for every file.
+    std::ifstream first(merge_options.partials.front(), std::ios::binary);
+    partial_t kind;
+    if (!readPartialKind(first, kind)) {
+        LOGGER.error << "From: " << __FILE__ << ":" << __LINE__ << std::endl;
+        LOGGER.error << "Invalid argument. Not a partial result: " << merge_options.partials.front() << std::endl;
+        exit(EINVAL);
+    }
+    first.close();
+
+    LOGGER.info << "Merging " << merge_options.partials.size() << " partial results" << std::endl;
+    switch (kind) {
+        case partial_t::motif :
+            mergeFiles<motifRegion>(common_options, merge_options.partials, kind);
+            break;
+        case partial_t::variant :
+            mergeFiles<variantRegion>(common_options, merge_options.partials, kind);
+            break;
+        case partial_t::telomere :
+            mergeFiles<telomereRegion>(common_options, merge_options.partials, kind);
+            break;
+        default:
+            LOGGER.error << "Invalid argument. Unknown partial result: " << merge_options.partials.front()
+                         << std::endl;
+            exit(EINVAL);
+    }
+
+}
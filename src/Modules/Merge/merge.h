@@ -0,0 +1,39 @@
+#ifndef GEAR_MERGE_H
+#define GEAR_MERGE_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <string>
+#include "options.h"
+#include "partialResult.h"
+
+namespace cmri {
+
+    //Combine partial results (output.partial of MotifCount, VariantCallAnalysis or GenomeAnalysis runs with
+    //common.partial, e.g. one per lane or shard) into a single output.json, reading every file once.
+    //All partials must come from the same task; the counts of a region found in several of them are added.
+    void mainMerge(const common_options_t &common_options, const merge_options_t &merge_options);
+
+}
+
+#endif //GEAR_MERGE_H
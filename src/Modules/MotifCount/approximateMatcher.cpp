@@ -0,0 +1,63 @@
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+
+#include "approximateMatcher.h"
+#include <stdexcept>
+
+
+cmri::approximateMatcher::approximateMatcher(const std::vector<std::string> &_patterns, distanceType _distance,
+                                             int32_t _max_distance)
+        : patterns(_patterns), distance(_distance), max_distance(_max_distance) {
+
+    if (!supports(patterns, max_distance)) {
+        throw std::invalid_argument("approximate patterns must have 1 to 64 bases and more bases than max_distance");
+    }
+
+    const size_t n = patterns.size();
+    peq.assign(256 * n, 0);
+    last_bit.resize(n);
+    window.resize(n);
+    min_length.resize(n);
+    for (size_t id = 0; id < n; id++) {
+        const std::string &pattern = patterns[id];
+        for (size_t i = 0; i < pattern.size(); i++) {
+            peq[static_cast<uint8_t>(pattern[i]) * n + id] |= uint64_t(1) << i;
+        }
+        last_bit[id] = uint64_t(1) << (pattern.size() - 1);
+        const int64_t m = pattern.size();
+        min_length[id] = distance == distanceType::edit ? m - max_distance : m;
+        window[id] = std::min<int64_t>(min_length[id], 2 * max_distance + 1);
+    }
+}
+
+
+bool cmri::approximateMatcher::supports(const std::vector<std::string> &patterns, int32_t max_distance) {
+    if (max_distance < 0) { return false; }
+    for (auto &pattern : patterns) {
+        if (pattern.empty() || pattern.size() > static_cast<size_t>(max_length) ||
+            pattern.size() <= static_cast<size_t>(max_distance)) { return false; }
+    }
+    return true;
+}
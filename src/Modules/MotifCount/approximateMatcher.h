@@ -0,0 +1,204 @@
+#ifndef GEAR_APPROXIMATEMATCHER_H
+#define GEAR_APPROXIMATEMATCHER_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cmri {
+
+    //hamming: substitutions only, edit: substitutions, insertions and deletions.
+    enum class distanceType { hamming, edit };
+
+    //Matcher for patterns of at most 64 bytes that allows up to max_distance differences, all patterns advance
+    //together in a single pass over the read. Bit-parallel: one machine word per pattern holds the state of every
+    //pattern prefix, updated with a few word operations per base (shift-and with one word per error level for
+    //hamming, Myers' bit-vector algorithm for edit). Bytes are compared literally, as with the exact motifs.
+    //
+    //Ends within distance come in clusters around each occurrence (an edit occurrence also ends up to max_distance
+    //bases before or after its best end). The first end within distance opens a window of 2 * max_distance + 1 ends,
+    //the best end in the window (fewest differences, then leftmost) is the hit, and the next hit must not overlap
+    //it: it ends at least the shortest occurrence length (pattern length, minus max_distance for edit) later, which
+    //also caps the window. With max_distance 0 this gives the same non overlapping hits as the exact motifs.
+    class approximateMatcher {
+
+        struct candidate_t {
+            int64_t window_start = 0;
+            int64_t end = -1; //-1: no pending hit
+            int32_t distance = 0;
+            int64_t next_end = 0; //first end allowed after the last hit
+            int64_t last_end = -1; //end of the last hit
+        };
+
+        std::vector<std::string> patterns;
+        std::vector<uint64_t> peq; //[byte * patterns + id]: bit i set if pattern id has that byte at position i
+        std::vector<uint64_t> last_bit; //per pattern, bit of its last position
+        std::vector<int64_t> window; //per pattern, ends compared for a hit
+        std::vector<int64_t> min_length; //per pattern, shortest occurrence
+        distanceType distance;
+        int32_t max_distance;
+
+    public:
+
+        static const int32_t max_length = 64;
+
+        approximateMatcher(const std::vector<std::string> &_patterns, distanceType _distance, int32_t _max_distance);
+
+        //true when every pattern is non empty, at most max_length bytes and longer than the distance.
+        static bool supports(const std::vector<std::string> &patterns, int32_t max_distance);
+
+        inline size_t size() const { return patterns.size(); }
+
+        inline const std::string &getPattern(size_t id) const { return patterns[id]; }
+
+        //calls on_match(pattern id, start position, length) for every hit, ordered by end position for each pattern.
+        //Edit hits report the pattern length bases ending at the hit (fewer at the read start or after the previous
+        //hit), the alignment itself is not traced back.
+        template<class F>
+        inline void scan(const std::string &sequence, F on_match) const {
+            const size_t n = patterns.size();
+            if (n == 0 || sequence.empty()) { return; }
+
+            thread_local std::vector<candidate_t> candidates;
+            candidates.assign(n, candidate_t());
+
+            auto hit = [&](size_t id, int64_t end, int32_t d) {
+                auto &c = candidates[id];
+                if (c.end >= 0) {
+                    if (end < c.window_start + window[id]) {
+                        if (d < c.distance) {
+                            c.end = end;
+                            c.distance = d;
+                        }
+                        return;
+                    }
+                    report(id, c, on_match);
+                }
+                if (end >= c.next_end) {
+                    c.window_start = end;
+                    c.end = end;
+                    c.distance = d;
+                }
+            };
+
+            if (distance == distanceType::hamming) {
+                scanHamming(sequence, hit);
+            } else {
+                scanEdit(sequence, hit);
+            }
+            for (size_t id = 0; id < n; id++) {
+                if (candidates[id].end >= 0) { report(id, candidates[id], on_match); }
+            }
+        }
+
+    private:
+
+        template<class F>
+        inline void report(size_t id, candidate_t &c, F &on_match) const {
+            const int64_t start = std::max<int64_t>(c.end + 1 - static_cast<int64_t>(patterns[id].size()),
+                                                    c.last_end + 1);
+            on_match(static_cast<int32_t>(id), static_cast<size_t>(start), static_cast<size_t>(c.end + 1 - start));
+            c.next_end = c.end + min_length[id];
+            c.last_end = c.end;
+            c.end = -1;
+        }
+
+        //shift-and, state[id * (k + 1) + e]: bit i set if the pattern prefix of length i + 1 ends here with at
+        //most e substitutions.
+        template<class H>
+        inline void scanHamming(const std::string &sequence, H &hit) const {
+            const size_t n = patterns.size();
+            const size_t levels = max_distance + 1;
+            thread_local std::vector<uint64_t> state;
+            state.assign(n * levels, 0);
+
+            uint64_t *words = state.data();
+            const uint64_t *table = peq.data();
+            const uint64_t *high = last_bit.data();
+            for (size_t j = 0; j < sequence.size(); j++) {
+                const uint64_t *eq = table + static_cast<uint8_t>(sequence[j]) * n;
+                for (size_t id = 0; id < n; id++) {
+                    uint64_t *r = words + id * levels;
+                    uint64_t previous = r[0];
+                    r[0] = (previous << 1 | 1) & eq[id];
+                    for (size_t e = 1; e < levels; e++) {
+                        const uint64_t current = r[e];
+                        r[e] = ((current << 1 | 1) & eq[id]) | (previous << 1 | 1);
+                        previous = current;
+                    }
+                    //the levels are nested, the last one tells if there is a hit at all.
+                    if (!(r[levels - 1] & high[id])) { continue; }
+                    for (size_t e = 0; e < levels; e++) {
+                        if (r[e] & high[id]) {
+                            hit(id, j, static_cast<int32_t>(e));
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        //Myers (1999): vertical delta vectors of the dynamic programming column and the score of its last row.
+        //The text side row is zero, so an occurrence may start anywhere.
+        template<class H>
+        inline void scanEdit(const std::string &sequence, H &hit) const {
+            const size_t n = patterns.size();
+            thread_local std::vector<uint64_t> pv, mv;
+            thread_local std::vector<int32_t> score;
+            pv.assign(n, ~uint64_t(0));
+            mv.assign(n, 0);
+            score.resize(n);
+            for (size_t id = 0; id < n; id++) { score[id] = static_cast<int32_t>(patterns[id].size()); }
+
+            uint64_t *vp = pv.data();
+            uint64_t *vm = mv.data();
+            int32_t *last_row = score.data();
+            const uint64_t *table = peq.data();
+            const uint64_t *high = last_bit.data();
+            const int32_t k = max_distance;
+            for (size_t j = 0; j < sequence.size(); j++) {
+                const uint64_t *eq = table + static_cast<uint8_t>(sequence[j]) * n;
+                for (size_t id = 0; id < n; id++) {
+                    const uint64_t p = vp[id];
+                    const uint64_t m = vm[id];
+                    const uint64_t xv = eq[id] | m;
+                    const uint64_t xh = (((eq[id] & p) + p) ^ p) | eq[id];
+                    const uint64_t ph = m | ~(xh | p);
+                    const uint64_t mh = p & xh;
+                    last_row[id] += static_cast<int32_t>((ph & high[id]) != 0) - static_cast<int32_t>((mh & high[id]) != 0);
+                    const uint64_t phs = ph << 1;
+                    vp[id] = (mh << 1) | ~(xv | phs);
+                    vm[id] = phs & xv;
+                    if (last_row[id] <= k) { hit(id, j, last_row[id]); }
+                }
+            }
+        }
+
+    };
+
+}
+
+#endif //GEAR_APPROXIMATEMATCHER_H
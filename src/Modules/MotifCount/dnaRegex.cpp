@@ -0,0 +1,448 @@
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "dnaRegex.h"
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+
+namespace {
+
+    typedef std::bitset<256> byte_set_t;
+
+    //Syntax tree of the supported subset of ECMAScript regular expressions.
+    struct regex_node_t {
+        enum type_t { SET, CONCAT, ALTERNATIVE, REPEAT } type;
+        byte_set_t set;
+        std::vector<std::unique_ptr<regex_node_t>> children;
+        int min = 1;
+        int max = 1; //-1 unbounded
+
+        explicit regex_node_t(type_t _type) : type(_type) {}
+
+        //shortest and longest match, -1 for unbounded.
+        int minLength() const {
+            switch (type) {
+                case SET:
+                    return 1;
+                case CONCAT: {
+                    int result = 0;
+                    for (auto &child : children) { result += child->minLength(); }
+                    return result;
+                }
+                case ALTERNATIVE: {
+                    int result = -1;
+                    for (auto &child : children) {
+                        int l = child->minLength();
+                        result = result < 0 ? l : std::min(result, l);
+                    }
+                    return std::max(result, 0);
+                }
+                case REPEAT:
+                    return min * children[0]->minLength();
+            }
+            return 0;
+        }
+
+        int maxLength() const {
+            switch (type) {
+                case SET:
+                    return 1;
+                case CONCAT: {
+                    int result = 0;
+                    for (auto &child : children) {
+                        int l = child->maxLength();
+                        if (l < 0) { return -1; }
+                        result += l;
+                    }
+                    return result;
+                }
+                case ALTERNATIVE: {
+                    int result = 0;
+                    for (auto &child : children) {
+                        int l = child->maxLength();
+                        if (l < 0) { return -1; }
+                        result = std::max(result, l);
+                    }
+                    return result;
+                }
+                case REPEAT: {
+                    int l = children[0]->maxLength();
+                    if (l == 0) { return 0; }
+                    if (l < 0 || max < 0) { return -1; }
+                    return max * l;
+                }
+            }
+            return 0;
+        }
+    };
+
+    //Recursive descent parser, throws std::invalid_argument on syntax outside the supported subset.
+    class regexParser {
+
+        const std::string &pattern;
+        size_t position = 0;
+
+        inline bool end() const { return position >= pattern.size(); }
+
+        inline char peek() const { return pattern[position]; }
+
+        std::unique_ptr<regex_node_t> set(const byte_set_t &bytes) {
+            std::unique_ptr<regex_node_t> node(new regex_node_t(regex_node_t::SET));
+            node->set = bytes;
+            return node;
+        }
+
+        int number() {
+            size_t first = position;
+            while (!end() && std::isdigit(peek())) { position++; }
+            if (first == position) { throw std::invalid_argument("expecting a number"); }
+            return std::stoi(pattern.substr(first, position - first));
+        }
+
+        std::unique_ptr<regex_node_t> alternative() {
+            std::unique_ptr<regex_node_t> node(new regex_node_t(regex_node_t::ALTERNATIVE));
+            node->children.push_back(concat());
+            while (!end() && peek() == '|') {
+                position++;
+                node->children.push_back(concat());
+            }
+            if (node->children.size() == 1) { return std::move(node->children[0]); }
+            return node;
+        }
+
+        std::unique_ptr<regex_node_t> concat() {
+            std::unique_ptr<regex_node_t> node(new regex_node_t(regex_node_t::CONCAT));
+            while (!end() && peek() != '|' && peek() != ')') {
+                node->children.push_back(repeat());
+            }
+            return node;
+        }
+
+        std::unique_ptr<regex_node_t> repeat() {
+            auto node = atom();
+            while (!end() && (peek() == '{' || peek() == '?' || peek() == '*' || peek() == '+')) {
+                std::unique_ptr<regex_node_t> repeat_node(new regex_node_t(regex_node_t::REPEAT));
+                char quantifier = pattern[position++];
+                switch (quantifier) {
+                    case '?':
+                        repeat_node->min = 0;
+                        break;
+                    case '*':
+                        repeat_node->min = 0;
+                        repeat_node->max = -1;
+                        break;
+                    case '+':
+                        repeat_node->max = -1;
+                        break;
+                    default:
+                        repeat_node->min = number();
+                        repeat_node->max = repeat_node->min;
+                        if (!end() && peek() == ',') {
+                            position++;
+                            repeat_node->max = !end() && peek() == '}' ? -1 : number();
+                        }
+                        if (end() || pattern[position++] != '}') { throw std::invalid_argument("expecting }"); }
+                }
+                //lazy quantifiers change which match is reported.
+                if (!end() && peek() == '?') { throw std::invalid_argument("lazy quantifier"); }
+                repeat_node->children.push_back(std::move(node));
+                node = std::move(repeat_node);
+            }
+            return node;
+        }
+
+        std::unique_ptr<regex_node_t> atom() {
+            char c = pattern[position++];
+            byte_set_t bytes;
+            switch (c) {
+                case '(': {
+                    if (!end() && peek() == '?') {
+                        if (pattern.compare(position, 2, "?:") != 0) { throw std::invalid_argument("assertion"); }
+                        position += 2;
+                    }
+                    auto node = alternative();
+                    if (end() || pattern[position++] != ')') { throw std::invalid_argument("expecting )"); }
+                    return node;
+                }
+                case '.':
+                    bytes.set();
+                    bytes.reset('\n');
+                    bytes.reset('\r');
+                    return set(bytes);
+                case '[':
+                    return characterClass();
+                case '\\':
+                    if (end() || std::isalnum(peek())) { throw std::invalid_argument("escape sequence"); }
+                    bytes.set(static_cast<uint8_t>(pattern[position++]));
+                    return set(bytes);
+                case '^':
+                case '$':
+                case '*':
+                case '+':
+                case '?':
+                case '{':
+                case '}':
+                case ']':
+                    throw std::invalid_argument("unexpected character");
+                default:
+                    bytes.set(static_cast<uint8_t>(c));
+                    return set(bytes);
+            }
+        }
+
+        std::unique_ptr<regex_node_t> characterClass() {
+            byte_set_t bytes;
+            bool negate = !end() && peek() == '^';
+            if (negate) { position++; }
+            bool first = true;
+            while (!end() && (peek() != ']' || first)) {
+                first = false;
+                char from = pattern[position++];
+                if (from == '\\' || from == '[') { throw std::invalid_argument("escape in class"); }
+                char to = from;
+                if (position + 1 < pattern.size() && peek() == '-' && pattern[position + 1] != ']') {
+                    to = pattern[position + 1];
+                    position += 2;
+                }
+                for (int b = static_cast<uint8_t>(from); b <= static_cast<uint8_t>(to); b++) { bytes.set(b); }
+            }
+            if (end()) { throw std::invalid_argument("expecting ]"); }
+            position++;
+            if (negate) {
+                bytes.flip();
+                bytes.reset('\n');
+                bytes.reset('\r');
+            }
+            return set(bytes);
+        }
+
+    public:
+        explicit regexParser(const std::string &_pattern) : pattern(_pattern) {}
+
+        std::unique_ptr<regex_node_t> parse() {
+            auto node = alternative();
+            if (!end()) { throw std::invalid_argument("unbalanced )"); }
+            return node;
+        }
+
+    };
+
+    //Thompson automaton: every state has either byte edges or epsilon edges.
+    struct nfa_t {
+
+        struct state_t {
+            std::vector<std::pair<int, int>> edges; //byte set id, target
+            std::vector<int> epsilon;
+        };
+
+        std::vector<state_t> states;
+        std::vector<byte_set_t> sets;
+
+        int add() {
+            states.emplace_back();
+            return static_cast<int>(states.size()) - 1;
+        }
+
+        //returns the start and end states of the fragment.
+        std::pair<int, int> emit(const regex_node_t &node) {
+            switch (node.type) {
+                case regex_node_t::SET: {
+                    int s = add();
+                    int e = add();
+                    sets.push_back(node.set);
+                    states[s].edges.emplace_back(static_cast<int>(sets.size()) - 1, e);
+                    return {s, e};
+                }
+                case regex_node_t::CONCAT: {
+                    int s = add();
+                    int e = s;
+                    for (auto &child : node.children) {
+                        auto fragment = emit(*child);
+                        states[e].epsilon.push_back(fragment.first);
+                        e = fragment.second;
+                    }
+                    return {s, e};
+                }
+                case regex_node_t::ALTERNATIVE: {
+                    int s = add();
+                    int e = add();
+                    for (auto &child : node.children) {
+                        auto fragment = emit(*child);
+                        states[s].epsilon.push_back(fragment.first);
+                        states[fragment.second].epsilon.push_back(e);
+                    }
+                    return {s, e};
+                }
+                case regex_node_t::REPEAT: {
+                    //only fixed length patterns get here, min == max copies (one if the child is empty).
+                    int s = add();
+                    int e = s;
+                    int copies = node.children[0]->maxLength() == 0 ? 1 : node.min;
+                    for (int i = 0; i < copies; i++) {
+                        auto fragment = emit(*node.children[0]);
+                        states[e].epsilon.push_back(fragment.first);
+                        e = fragment.second;
+                    }
+                    return {s, e};
+                }
+            }
+            return {add(), add()};
+        }
+
+        void closure(std::vector<int> &set) const {
+            std::vector<bool> seen(states.size(), false);
+            std::vector<int> pending(set);
+            set.clear();
+            while (!pending.empty()) {
+                int state = pending.back();
+                pending.pop_back();
+                if (seen[state]) { continue; }
+                seen[state] = true;
+                set.push_back(state);
+                for (auto next : states[state].epsilon) { pending.push_back(next); }
+            }
+            std::sort(set.begin(), set.end());
+        }
+
+    };
+
+    //Top level sequence of a pattern, nested groups and fixed repeats expanded.
+    void flatten(const regex_node_t &node, std::vector<const regex_node_t *> &items) {
+        if (node.type == regex_node_t::CONCAT) {
+            for (auto &child : node.children) { flatten(*child, items); }
+        } else if (node.type == regex_node_t::REPEAT && node.min == node.max && node.min <= 64) {
+            for (int i = 0; i < node.min; i++) { flatten(*node.children[0], items); }
+        } else {
+            items.push_back(&node);
+        }
+    }
+
+    //Longest run of single bytes along the top level sequence: every match contains it. offset is its position in
+    //the match, -1 when something of variable length comes before it.
+    void requiredLiteral(const regex_node_t &tree, std::string &literal, int &offset) {
+        std::vector<const regex_node_t *> items;
+        flatten(tree, items);
+
+        std::string run;
+        int run_offset = 0;
+        int position = 0; //-1 once the length before the current item varies
+        for (auto item : items) {
+            if (item->type == regex_node_t::SET && item->set.count() == 1) {
+                if (run.empty()) { run_offset = position; }
+                for (int b = 0; b < 256; b++) {
+                    if (item->set[b]) { run += static_cast<char>(b); }
+                }
+            } else {
+                run.clear();
+            }
+            if (run.size() > literal.size()) {
+                literal = run;
+                offset = run_offset;
+            }
+            int min = item->minLength(), max = item->maxLength();
+            position = position < 0 || min != max ? -1 : position + min;
+        }
+    }
+
+}
+
+
+cmri::dnaRegex::dnaRegex(const std::string &_pattern) : pattern(_pattern) {
+    try {
+        requiredLiteral(*regexParser(pattern).parse(), literal, literal_offset);
+    }
+    catch (std::exception &e) {
+        literal.clear(); //syntax outside the parser subset, no prefilter
+    }
+    dfa = compile();
+    if (!dfa) { fallback = std::regex(pattern); }
+}
+
+
+bool cmri::dnaRegex::compile() {
+
+    std::unique_ptr<regex_node_t> tree;
+    try {
+        tree = regexParser(pattern).parse();
+    }
+    catch (std::exception &e) {
+        return false;
+    }
+
+    int length = tree->maxLength();
+    if (length <= 0 || tree->minLength() != length) { return false; }
+    match_length = length;
+
+    nfa_t nfa;
+    auto fragment = nfa.emit(*tree);
+
+    //bytes with the same membership in every set of the automaton are one class.
+    std::map<std::vector<bool>, int> signatures;
+    for (int b = 0; b < 256; b++) {
+        std::vector<bool> signature(nfa.sets.size());
+        for (size_t i = 0; i < nfa.sets.size(); i++) { signature[i] = nfa.sets[i][b]; }
+        auto found = signatures.emplace(signature, static_cast<int>(signatures.size()));
+        byte_class[b] = static_cast<uint8_t>(found.first->second);
+    }
+    n_classes = static_cast<int32_t>(signatures.size());
+    std::vector<int> class_byte(n_classes); //any byte of the class
+    for (int b = 0; b < 256; b++) { class_byte[byte_class[b]] = b; }
+
+    //subset construction, the start state is added at every step so a match may start anywhere.
+    std::vector<int> start_set{fragment.first};
+    nfa.closure(start_set);
+    std::map<std::vector<int>, int32_t> dfa_states;
+    std::vector<std::vector<int>> pending{start_set};
+    dfa_states[start_set] = 0;
+    transition.clear();
+    accepting.clear();
+    for (size_t current = 0; current < pending.size(); current++) {
+        if (pending.size() > max_states) {
+            transition.clear();
+            accepting.clear();
+            return false;
+        }
+        std::vector<int> set = pending[current];
+        accepting.push_back(std::binary_search(set.begin(), set.end(), fragment.second));
+        for (int32_t c = 0; c < n_classes; c++) {
+            std::vector<int> next(start_set);
+            int b = class_byte[c];
+            for (auto state : set) {
+                for (auto &edge : nfa.states[state].edges) {
+                    if (nfa.sets[edge.first][b]) { next.push_back(edge.second); }
+                }
+            }
+            nfa.closure(next);
+            auto found = dfa_states.emplace(next, static_cast<int32_t>(pending.size()));
+            if (found.second) { pending.push_back(next); }
+            transition.push_back(found.first->second);
+        }
+    }
+
+    return true;
+}
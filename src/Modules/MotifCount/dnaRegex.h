@@ -0,0 +1,121 @@
+#ifndef GEAR_DNAREGEX_H
+#define GEAR_DNAREGEX_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace cmri {
+
+    //Regular expression compiled once and matched against many reads.
+    //Patterns whose matches all have the same length (literals, '.', [classes], groups, {n}, and alternatives of equal
+    //length, e.g. (TTAGGG)(.{1})(TCAGGG)) are compiled into a DFA over the byte classes of the pattern and matched in a
+    //single linear pass; for them the leftmost match is also the first one to end, so results are the same as
+    //std::regex_search. Any other pattern, or a DFA with more than max_states states, falls back to a std::regex.
+    //The longest literal every match must contain (TTAGGG in (TTAGGG)(.{1})(TTAGGG)) is searched first: reads without
+    //it are skipped, and the DFA only runs from the first position a match around the next occurrence could start.
+    class dnaRegex {
+
+        std::string pattern;
+        std::string literal; //required literal, empty if none
+        int literal_offset = -1; //position of literal in every match, -1 if it varies
+        bool dfa = false;
+        size_t match_length = 0;
+        uint8_t byte_class[256];
+        int32_t n_classes = 0;
+        std::vector<int32_t> transition; //state * n_classes + byte class -> state
+        std::vector<uint8_t> accepting;
+        std::regex fallback;
+
+        bool compile();
+
+        //first position >= from where a match containing the literal at literal_offset may start, npos if none.
+        inline size_t nextWindow(const std::string &sequence, size_t from) const {
+            size_t found = sequence.find(literal, from + literal_offset);
+            if (found == std::string::npos) { return std::string::npos; }
+            return std::max(from, found - literal_offset);
+        }
+
+    public:
+
+        static const size_t max_states = 4096;
+
+        explicit dnaRegex(const std::string &_pattern);
+
+        inline const std::string &getPattern() const { return pattern; }
+
+        inline bool isDfa() const { return dfa; }
+
+        inline const std::string &getLiteral() const { return literal; }
+
+        //calls on_match(start, length) for every non empty match, each search starts where the previous match ended
+        //(as searching again on the match suffix).
+        template<class F>
+        inline void scan(const std::string &sequence, F on_match) const {
+            if (!literal.empty() && sequence.find(literal) == std::string::npos) { return; }
+
+            if (dfa) {
+                const bool windows = !literal.empty() && literal_offset >= 0;
+                int32_t state = 0;
+                const size_t length = sequence.size();
+                size_t i = windows ? nextWindow(sequence, 0) : 0;
+                while (i < length) {
+                    state = transition[state * n_classes + byte_class[static_cast<uint8_t>(sequence[i])]];
+                    if (accepting[state]) {
+                        on_match(i + 1 - match_length, match_length);
+                        state = 0;
+                        if (windows) {
+                            i = nextWindow(sequence, i + 1);
+                            continue;
+                        }
+                    }
+                    i++;
+                }
+                return;
+            }
+
+            std::smatch match;
+            auto begin = sequence.cbegin();
+            while (std::regex_search(begin, sequence.cend(), match, fallback)) {
+                size_t start = std::distance(sequence.cbegin(), match[0].first);
+                size_t length = match.length(0);
+                begin = match[0].second;
+                //empty matches are not reported, they would be found again at the same place.
+                if (length == 0) {
+                    if (begin == sequence.cend()) { break; }
+                    ++begin;
+                    continue;
+                }
+                on_match(start, length);
+            }
+        }
+
+    };
+
+}
+
+#endif //GEAR_DNAREGEX_H
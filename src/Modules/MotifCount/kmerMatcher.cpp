@@ -0,0 +1,178 @@
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "kmerMatcher.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GEAR_KMER_X86
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+    struct base_table_t {
+        uint8_t code[256];
+
+        base_table_t() {
+            std::fill(code, code + 256, 4);
+            code[static_cast<uint8_t>('A')] = 0;
+            code[static_cast<uint8_t>('C')] = 1;
+            code[static_cast<uint8_t>('G')] = 2;
+            code[static_cast<uint8_t>('T')] = 3;
+        }
+    };
+
+    const base_table_t base_table;
+
+    void encodeScalar(const char *sequence, size_t length, uint8_t *codes) {
+        for (size_t i = 0; i < length; i++) { codes[i] = base_table.code[static_cast<uint8_t>(sequence[i])]; }
+    }
+
+#ifdef GEAR_KMER_X86
+
+    __attribute__((target("sse4.1")))
+    void encodeSse41(const char *sequence, size_t length, uint8_t *codes) {
+        const __m128i a = _mm_set1_epi8('A'), c = _mm_set1_epi8('C'), g = _mm_set1_epi8('G'), t = _mm_set1_epi8('T');
+        const __m128i one = _mm_set1_epi8(1), two = _mm_set1_epi8(2), three = _mm_set1_epi8(3);
+        const __m128i other = _mm_set1_epi8(4);
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sequence + i));
+            __m128i result = _mm_blendv_epi8(other, _mm_setzero_si128(), _mm_cmpeq_epi8(bytes, a));
+            result = _mm_blendv_epi8(result, one, _mm_cmpeq_epi8(bytes, c));
+            result = _mm_blendv_epi8(result, two, _mm_cmpeq_epi8(bytes, g));
+            result = _mm_blendv_epi8(result, three, _mm_cmpeq_epi8(bytes, t));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(codes + i), result);
+        }
+        encodeScalar(sequence + i, length - i, codes + i);
+    }
+
+    __attribute__((target("avx2")))
+    void encodeAvx2(const char *sequence, size_t length, uint8_t *codes) {
+        const __m256i a = _mm256_set1_epi8('A'), c = _mm256_set1_epi8('C');
+        const __m256i g = _mm256_set1_epi8('G'), t = _mm256_set1_epi8('T');
+        const __m256i one = _mm256_set1_epi8(1), two = _mm256_set1_epi8(2), three = _mm256_set1_epi8(3);
+        const __m256i other = _mm256_set1_epi8(4);
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sequence + i));
+            __m256i result = _mm256_blendv_epi8(other, _mm256_setzero_si256(), _mm256_cmpeq_epi8(bytes, a));
+            result = _mm256_blendv_epi8(result, one, _mm256_cmpeq_epi8(bytes, c));
+            result = _mm256_blendv_epi8(result, two, _mm256_cmpeq_epi8(bytes, g));
+            result = _mm256_blendv_epi8(result, three, _mm256_cmpeq_epi8(bytes, t));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(codes + i), result);
+        }
+        encodeSse41(sequence + i, length - i, codes + i);
+    }
+
+#endif
+
+}
+
+
+bool cmri::supportedBaseKernel(baseKernel kernel) {
+#ifdef GEAR_KMER_X86
+    switch (kernel) {
+        case baseKernel::avx2:
+            return __builtin_cpu_supports("avx2");
+        case baseKernel::sse41:
+            return __builtin_cpu_supports("sse4.1");
+        default:
+            return true;
+    }
+#else
+    return kernel == baseKernel::scalar;
+#endif
+}
+
+
+cmri::baseKernel cmri::bestBaseKernel() {
+    static const baseKernel best = supportedBaseKernel(baseKernel::avx2) ? baseKernel::avx2 :
+                                   supportedBaseKernel(baseKernel::sse41) ? baseKernel::sse41 : baseKernel::scalar;
+    return best;
+}
+
+
+void cmri::encodeBases(const char *sequence, size_t length, uint8_t *codes, baseKernel kernel) {
+#ifdef GEAR_KMER_X86
+    if (kernel == baseKernel::avx2) {
+        encodeAvx2(sequence, length, codes);
+        return;
+    }
+    if (kernel == baseKernel::sse41) {
+        encodeSse41(sequence, length, codes);
+        return;
+    }
+#endif
+    encodeScalar(sequence, length, codes);
+}
+
+
+bool cmri::kmerMatcher::supports(const std::vector<std::string> &patterns) {
+    for (auto &pattern : patterns) {
+        if (pattern.empty() || pattern.size() > max_length) { return false; }
+        for (auto c : pattern) {
+            if (base_table.code[static_cast<uint8_t>(c)] > 3) { return false; }
+        }
+    }
+    return true;
+}
+
+
+cmri::kmerMatcher::kmerMatcher(const std::vector<std::string> &_patterns, baseKernel _kernel)
+        : patterns(_patterns), kernel(supportedBaseKernel(_kernel) ? _kernel : baseKernel::scalar) {
+
+    if (!supports(patterns)) {
+        throw std::invalid_argument("kmerMatcher: motifs must be A,C,G,T literals of at most 32 bases");
+    }
+
+    std::map<int32_t, std::vector<std::pair<uint64_t, int32_t>>> by_length;
+    for (size_t id = 0; id < patterns.size(); id++) {
+        uint64_t code = 0;
+        for (auto c : patterns[id]) { code = code << 2 | base_table.code[static_cast<uint8_t>(c)]; }
+        by_length[static_cast<int32_t>(patterns[id].size())].emplace_back(code, static_cast<int32_t>(id));
+    }
+
+    for (auto &item : by_length) {
+        length_group_t group;
+        group.length = item.first;
+        group.mask = group.length == 32 ? ~0ULL : (1ULL << (2 * group.length)) - 1;
+        const int32_t filter_bases = std::min(group.length, 10);
+        group.filter_mask = (1ULL << (2 * filter_bases)) - 1;
+        group.filter.assign(std::max<uint64_t>(1, (group.filter_mask + 1) >> 6), 0);
+
+        std::sort(item.second.begin(), item.second.end());
+        for (auto &motif : item.second) {
+            group.codes.push_back(motif.first);
+            group.ids.push_back(motif.second);
+            const uint64_t f = motif.first & group.filter_mask;
+            group.filter[f >> 6] |= 1ULL << (f & 63);
+        }
+        groups.push_back(group);
+    }
+}
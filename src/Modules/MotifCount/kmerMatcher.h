@@ -0,0 +1,117 @@
+#ifndef GEAR_KMERMATCHER_H
+#define GEAR_KMERMATCHER_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cmri {
+
+    //Byte to 2-bit base kernels: A,C,G,T -> 0..3, any other byte (N, lower case, ...) -> 4.
+    enum class baseKernel { scalar, sse41, avx2 };
+
+    //fastest kernel supported by the running cpu.
+    baseKernel bestBaseKernel();
+
+    bool supportedBaseKernel(baseKernel kernel);
+
+    void encodeBases(const char *sequence, size_t length, uint8_t *codes, baseKernel kernel);
+
+    //Matcher for a set of literal motifs over A,C,G,T of at most 32 bases (see supports).
+    //Reads are 2-bit encoded with a vector kernel, then one pass per motif length checks the rolling code at every
+    //position against the motif codes; a bit filter on the last bases rejects most positions with a single load.
+    //Same hits as motifMatcher: any byte other than A,C,G,T breaks a k-mer.
+    class kmerMatcher {
+
+        struct length_group_t {
+            int32_t length;
+            uint64_t mask;
+            uint64_t filter_mask;
+            std::vector<uint64_t> filter; //bit set over the last (up to 10) bases of the motif codes
+            std::vector<uint64_t> codes; //sorted
+            std::vector<int32_t> ids; //motif id of each code
+        };
+
+        std::vector<std::string> patterns;
+        std::vector<length_group_t> groups; //by increasing length
+        baseKernel kernel;
+
+    public:
+
+        static const int32_t max_length = 32;
+
+        explicit kmerMatcher(const std::vector<std::string> &_patterns, baseKernel _kernel = bestBaseKernel());
+
+        //true when every motif is a non empty string of A,C,G,T of at most max_length bases.
+        static bool supports(const std::vector<std::string> &patterns);
+
+        inline size_t size() const { return patterns.size(); }
+
+        inline const std::string &getPattern(size_t id) const { return patterns[id]; }
+
+        //calls on_match(motif id, start position) for every occurrence, ordered by end position for each motif
+        //(motifs of different lengths are reported in separate passes).
+        template<class F>
+        inline void scan(const std::string &sequence, F on_match) const {
+            const size_t length = sequence.size();
+            if (groups.empty() || length == 0) { return; }
+
+            thread_local std::vector<uint8_t> codes;
+            if (codes.size() < length) { codes.resize(length); }
+            encodeBases(sequence.data(), length, codes.data(), kernel);
+
+            for (auto &group : groups) { scanGroup(group, codes.data(), length, on_match); }
+        }
+
+    private:
+
+        template<class F>
+        static inline void scanGroup(const length_group_t &group, const uint8_t *codes, size_t length, F &on_match) {
+            const uint64_t mask = group.mask;
+            const uint64_t filter_mask = group.filter_mask;
+            const uint64_t *filter = group.filter.data();
+            const size_t k = group.length;
+            uint64_t code = 0;
+            size_t valid_from = 0; //first position after the last non A,C,G,T byte
+            for (size_t i = 0; i < length; i++) {
+                const uint8_t base = codes[i];
+                if (base > 3) {
+                    valid_from = i + 1;
+                    continue;
+                }
+                code = (code << 2 | base) & mask;
+                const uint64_t f = code & filter_mask;
+                if (!(filter[f >> 6] >> (f & 63) & 1) || i + 1 - valid_from < k) { continue; }
+                for (size_t m = 0; m < group.codes.size(); m++) {
+                    if (group.codes[m] == code) { on_match(group.ids[m], i + 1 - k); } //codes repeat for equal motifs
+                }
+            }
+        }
+
+    };
+
+}
+
+#endif //GEAR_KMERMATCHER_H
@@ -23,6 +23,103 @@
 //
 
 #include "motifCount.h"
+#include "jsonWriter.h"
+
+
+namespace {
+
+    //histogram bin of a hit: rounded mean phred value of its bases from the read prefix sums,
+    //0 when out of range or the read has no qualities.
+    inline unsigned int qualityBin(const std::vector<uint32_t> &quality_sum, size_t start, size_t length) {
+        int qv_mean = 0;
+        if (length > 0 && quality_sum.size() > start + length) { //fasta and csv reads have no qualities
+            qv_mean = static_cast<int>(std::round(
+                    static_cast<double>(quality_sum[start + length] - quality_sum[start]) / length));
+        }
+        if (qv_mean < 0 || qv_mean > 99) { qv_mean = 0; }
+        return qv_mean;
+    }
+
+    template<class M>
+    void countMotifHits(const M &matcher, const std::string &sequence, const std::vector<uint32_t> &quality_sum,
+                        cmri::qvHistogram &histogram) {
+
+        //per motif, the next position a hit may start at: hits of the same motif do not overlap (as with repeated find).
+        thread_local std::vector<size_t> next_start;
+        next_start.assign(matcher.size(), 0);
+
+        matcher.scan(sequence, [&](int32_t id, size_t start) {
+            if (start < next_start[id]) { return; }
+            size_t step = matcher.getPattern(id).size();
+            next_start[id] = start + step;
+            histogram.add(id, qualityBin(quality_sum, start, step));
+        });
+    }
+
+    const char checkpoint_magic[] = "GEARCKP2";
+
+    inline std::string checkpointFile(const cmri::common_options_t &common_options) {
+        return common_options.output_path + "/checkpoint.bin";
+    }
+
+    //checkpoint interval of the run, 0 (off) for inputs the reader cannot seek in.
+    int checkpointInterval(const cmri::motif_count_options_t &motif_count_options, cmri::sequenceReader &reader) {
+        if (motif_count_options.checkpoint > 0 && reader.tell() < 0) {
+            cmri::LOGGER.warning << "Checkpoints are not supported for csv input or indexed regions." << std::endl;
+            return 0;
+        }
+        return motif_count_options.checkpoint;
+    }
+
+    void saveCheckpoint(const cmri::common_options_t &common_options, cmri::sequenceReader &reader,
+                        const cmri::mapVectorMotifRegion &motif_map) {
+        cmri::motif_checkpoint_t checkpoint;
+        checkpoint.input_file = common_options.input_file;
+        checkpoint.file_size = reader.getFileSize();
+        checkpoint.position = reader.tell();
+        checkpoint.reads = reader.getCount();
+        checkpoint.shard_index = common_options.shard_index;
+        checkpoint.shard_count = common_options.shard_count;
+        cmri::writeCheckpoint(checkpointFile(common_options), checkpoint, motif_map);
+        cmri::LOGGER.debug << "Checkpoint after " << checkpoint.reads << " reads" << std::endl;
+    }
+
+    //with --resume, add the counts of the checkpoint to the map and move the reader to the first read not counted.
+    //Call it before copying the map into accumulators.
+    void resumeRun(const cmri::common_options_t &common_options, cmri::sequenceReader &reader,
+                   cmri::mapVectorMotifRegion &motif_map) {
+        if (!common_options.resume) { return; }
+        if (reader.tell() < 0) {
+            cmri::LOGGER.warning << "Resume is not supported for csv input or indexed regions, reading the whole input."
+                                 << std::endl;
+            return;
+        }
+
+        cmri::motif_checkpoint_t checkpoint;
+        if (!cmri::readCheckpoint(checkpointFile(common_options), checkpoint, motif_map)) {
+            cmri::LOGGER.warning << "No valid checkpoint in " << common_options.output_path
+                                 << ", reading the whole input." << std::endl;
+            return;
+        }
+        if (checkpoint.input_file != common_options.input_file || checkpoint.file_size != reader.getFileSize() ||
+            checkpoint.shard_index != common_options.shard_index ||
+            checkpoint.shard_count != common_options.shard_count) {
+            cmri::LOGGER.error << "From: " << __FILE__ << ":" << __LINE__ << std::endl;
+            cmri::LOGGER.error << "Invalid argument. The checkpoint was written for another input: "
+                               << checkpoint.input_file << " (shard " << checkpoint.shard_index << " of "
+                               << checkpoint.shard_count << ")" << std::endl;
+            exit(EINVAL);
+        }
+        if (!reader.seek(checkpoint.position, checkpoint.reads)) {
+            cmri::LOGGER.error << "From: " << __FILE__ << ":" << __LINE__ << std::endl;
+            cmri::LOGGER.error << "Unable to resume " << common_options.input_file << " at the checkpoint."
+                               << std::endl;
+            exit(EIO);
+        }
+        cmri::LOGGER.info << "Resuming after " << checkpoint.reads << " reads." << std::endl;
+    }
+
+}
 
 
 unsigned int cmri::searchMotif(std::string sequence, const std::string &motif) {
@@ -36,137 +133,298 @@ unsigned int cmri::searchMotif(std::string sequence, const std::string &motif) {
     return occurrences;
 }
 
-void cmri::searchMotifWFilter(std::string sequence, std::vector<int> quality,
+void cmri::searchMotifWFilter(const std::string &sequence, const std::vector<uint8_t> &quality,
                               std::map<std::string, std::map<unsigned int, unsigned int>> &motif_quality) {
 
-    for (auto &motif : motif_quality) {
-        std::string::size_type start = 0;
-        while ((start = sequence.find(motif.first, start)) != std::string::npos) {
-            int step = motif.first.size();
-            int qv_mean = 0;
-            for (int i = start; i < start + step; i++) {
-                qv_mean += quality[i];
-            }
-            qv_mean = static_cast<int>(std::round(qv_mean / step));
-            if (qv_mean < 0 || qv_mean > 99) { qv_mean = 0; }
-            motif.second[qv_mean]++;
-            // move start to find the rest of the string.
-            start += step;
-        }
-    }
+    std::vector<std::string> patterns;
+    for (auto &motif : motif_quality) { patterns.push_back(motif.first); }
+    qvHistogram histogram;
+    histogram.resize(patterns.size());
+    std::vector<uint32_t> quality_sum;
+    qualityPrefixSum(quality, quality_sum);
+    searchMotifWFilter(motifMatcher(patterns), sequence, quality_sum, histogram);
+    addHistogram(histogram, motif_quality);
 }
 
+void cmri::searchMotifWFilter(const motifMatcher &matcher, const std::string &sequence,
+                              const std::vector<uint32_t> &quality_sum, qvHistogram &histogram) {
+    countMotifHits(matcher, sequence, quality_sum, histogram);
+}
 
-unsigned int cmri::searchRegex(std::string sequence, const std::string &regex) {
+void cmri::searchMotifWFilter(const kmerMatcher &matcher, const std::string &sequence,
+                              const std::vector<uint32_t> &quality_sum, qvHistogram &histogram) {
+    countMotifHits(matcher, sequence, quality_sum, histogram);
+}
 
-    int occurrences = 0;
-    std::regex basic_regex(regex);
-    std::smatch match;
 
-    while (std::regex_search(sequence, match, basic_regex)) {
-        ++occurrences;
-        // suffix to find the rest of the string.
-        sequence = match.suffix().str();
-    }
+unsigned int cmri::searchRegex(std::string sequence, const std::string &regex) {
 
+    int occurrences = 0;
+    dnaRegex(regex).scan(sequence, [&](size_t, size_t) { ++occurrences; });
     return occurrences;
 }
 
 
-void cmri::searchRegex(std::string sequence, std::vector<int> quality,
+void cmri::searchRegex(std::string sequence, const std::vector<uint8_t> &quality,
                        std::map<std::string, std::map<unsigned int, unsigned int>> &regex_quality) {
 
+    std::vector<dnaRegex> regexes;
+    for (auto &regex : regex_quality) { regexes.emplace_back(regex.first); }
+    qvHistogram histogram;
+    histogram.resize(regexes.size());
+    std::vector<uint32_t> quality_sum;
+    qualityPrefixSum(quality, quality_sum);
+    searchRegex(regexes, sequence, quality_sum, histogram);
+    addHistogram(histogram, regex_quality);
+}
 
-    for (auto &regex : regex_quality) {
+void cmri::searchRegex(const std::vector<dnaRegex> &regexes, const std::string &sequence,
+                       const std::vector<uint32_t> &quality_sum, qvHistogram &histogram) {
 
-        std::regex basic_regex(regex.first);
-        std::smatch match;
+    for (size_t id = 0; id < regexes.size(); id++) {
+        regexes[id].scan(sequence, [&](size_t start, size_t length) {
+            histogram.add(id, qualityBin(quality_sum, start, length));
+        });
+    }
+}
 
-        while (std::regex_search(sequence, match, basic_regex)) {
 
-            int step = match.str().size();
-            int qv_mean = 0;
-            std::string::size_type start = match.position();
-            for (int i = start; i < start + step; i++) {
-                qv_mean += quality[i];
-            }
-            qv_mean = static_cast<int>(std::round(qv_mean / step));
-            if (qv_mean < 0 || qv_mean > 99) { qv_mean = 0; }
-            regex.second[qv_mean]++;
+void cmri::searchApproximate(const approximateMatcher &matcher, const std::string &sequence,
+                             const std::vector<uint32_t> &quality_sum, qvHistogram &histogram) {
+    matcher.scan(sequence, [&](int32_t id, size_t start, size_t length) {
+        histogram.add(id, qualityBin(quality_sum, start, length));
+    });
+}
 
-            // suffix to find the rest of the string.
-            sequence = match.suffix().str();
-        }
 
+void cmri::addHistogram(const qvHistogram &histogram,
+                        std::map<std::string, std::map<unsigned int, unsigned int>> &pattern_quality) {
+    size_t id = 0;
+    for (auto &pattern : pattern_quality) {
+        for (unsigned int qv = 0; qv < qvHistogram::bins; qv++) {
+            if (histogram.get(id, qv) > 0) { pattern.second[qv] += histogram.get(id, qv); }
+        }
+        id++;
     }
 }
 
 
-int cmri::searchRegexConsecutive(std::string sequence, const std::string &regex) {
+int cmri::searchRegexConsecutive(const std::string &sequence, const std::string &regex) {
 
     int occurrences = 0;
 
     std::regex basic_regex(regex);
     std::smatch match;
 
-    while (std::regex_search(sequence, match, basic_regex)) {
+    //search the suffix in place, without copying it.
+    auto begin = sequence.cbegin();
+    while (std::regex_search(begin, sequence.cend(), match, basic_regex)) {
         ++occurrences;
-        // suffix to find the rest of the string.
-        auto m = match.position() + match.length() - 6;
-        sequence = sequence.substr(m);
+        auto next = match[0].second - std::min<std::ptrdiff_t>(6, match.length(0));
+        //an empty or short match would be found again at the same place.
+        if (next <= begin) { next = begin + 1; }
+        if (next > sequence.cend()) { break; }
+        begin = next;
     }
 
     return occurrences;
 }
 
 
-cmri::mapVectorMotifRegion
-cmri::processWorker(mapVectorMotifRegion motif_map, const std::vector<cmri::read_item_t> &sequences, bool validate) {
+void cmri::searchRepeats(const tandemRepeatMatcher &matcher, const std::string &sequence, runHistogram &histogram) {
+    matcher.scan(sequence, [&](int32_t id, size_t, uint32_t units) { histogram.add(id, units); });
+}
+
 
+std::vector<std::string> cmri::getQueryRegions(const mapVectorMotifRegion &motif_map) {
 
+    std::vector<std::string> result;
     for (auto &item : motif_map) {
-        for (auto &m : item.second) {
-            m.resetCount();
+        for (auto &region : item.second) {
+            if (region.start == region.end) {
+                result.push_back(item.first);
+                break;
+            }
+            result.push_back(item.first + ":" + std::to_string(region.start) + "-" + std::to_string(region.end));
+        }
+    }
+    return result;
+}
+
+
+void cmri::compileMotifs(mapVectorMotifRegion &motif_map) {
+    for (auto &item : motif_map) {
+        for (auto &region : item.second) {
+            if (!region.motif_matcher || !region.regex_matcher) { region.compile(); }
         }
     }
+}
 
-    for (const auto &seq : sequences) {
 
-        if (motif_map.find(seq.name) != motif_map.end()) {
-            for (auto &item : motif_map[seq.name]) {
+cmri::motifRegionIndex
+cmri::buildRegionIndex(const mapVectorMotifRegion &motif_map, const std::vector<std::string> &contig_names) {
 
-                if (!item.intersect(seq.start, seq.end)) { continue; }
+    motifRegionIndex index;
+    index.slot_by_tid.assign(contig_names.size(), -1);
+    for (auto &item : motif_map) {
+        auto slot = static_cast<int32_t>(index.regions.size());
+        index.slot_by_name[item.first] = slot;
+        if (item.first == "other") { index.other_slot = slot; }
+
+        intervalIndex<uint32_t> regions;
+        for (uint32_t i = 0; i < item.second.size(); i++) {
+            auto &region = item.second[i];
+            if (region.start == region.end) {
+                regions.add(0, std::numeric_limits<uint32_t>::max(), i); //whole contig
+            } else {
+                regions.add(region.start, region.end, i);
+            }
+        }
+        regions.index();
+        index.regions.push_back(regions);
+    }
+    for (size_t tid = 0; tid < contig_names.size(); tid++) {
+        auto found = index.slot_by_name.find(contig_names[tid]);
+        if (found != index.slot_by_name.end()) { index.slot_by_tid[tid] = found->second; }
+    }
 
-                std::string sequence = seq.sequence;
-                if (validate) { for (auto &c: sequence) { c = toupper(c); }}
+    return index;
+}
 
-                searchMotifWFilter(sequence, seq.qvalue, item.motifs);
 
-                searchRegex(sequence, seq.qvalue, item.regex);
+std::vector<cmri::vectorMotifRegion *> cmri::regionSlots(mapVectorMotifRegion &motif_map) {
+    std::vector<vectorMotifRegion *> result;
+    for (auto &item : motif_map) { result.push_back(&item.second); }
+    return result;
+}
 
-                item.reads_count++;
-                item.total_bases += sequence.size();
 
-            }
+void cmri::countRead(const read_item_t &read, const std::string &sequence, const motifRegionIndex &index,
+                     const std::vector<vectorMotifRegion *> &slots) {
+
+    auto count = [&](motifRegion &item) {
+        if (item.kmer_matcher) {
+            searchMotifWFilter(*item.kmer_matcher, sequence, read.qsum, item.motif_counts);
         } else {
-            if (motif_map.find("other") != motif_map.end()) {
+            searchMotifWFilter(*item.motif_matcher, sequence, read.qsum, item.motif_counts);
+        }
+        searchRegex(*item.regex_matcher, sequence, read.qsum, item.regex_counts);
+        if (item.approximate_matcher) {
+            searchApproximate(*item.approximate_matcher, sequence, read.qsum, item.approximate_counts);
+        }
+        if (item.repeat_matcher) { searchRepeats(*item.repeat_matcher, sequence, item.repeat_counts); }
+        item.reads_count++;
+        item.total_bases += sequence.size();
+    };
+
+    int32_t slot = index.slot(read);
+    if (slot >= 0) {
+        //regions containing the read end, see genomeRegion::intersect.
+        auto &contig = *slots[slot];
+        index.regions[slot].find(read.end, [&](uint32_t region) { count(contig[region]); });
+    } else if (index.other_slot >= 0) {
+        for (auto &item : *slots[index.other_slot]) { count(item); }
+    }
+}
 
-                std::string sequence = seq.sequence;
-                if (validate) { for (auto &c: sequence) { c = toupper(c); }}
 
-                for (auto &item : motif_map["other"]) {
+cmri::motifAccumulator::motifAccumulator(const mapVectorMotifRegion &_motif_map, const motifRegionIndex &_index)
+        : motif_map(_motif_map), index(_index) {
+    for (auto &item : motif_map) {
+        for (auto &m : item.second) {
+            m.resetCount();
+        }
+    }
+    slots = regionSlots(motif_map);
+}
 
-                    searchMotifWFilter(sequence, seq.qvalue, item.motifs);
-                    searchRegex(sequence, seq.qvalue, item.regex);
-                    item.reads_count++;
-                    item.total_bases += sequence.size();
-                }
-            }
+
+void cmri::motifAccumulator::count(const read_batch_t &batch, bool validate) {
+
+    for (const auto &seq : batch) {
+
+        const std::string *sequence = &seq.sequence;
+        if (validate) {
+            upper_sequence.assign(seq.sequence);
+            for (auto &c: upper_sequence) { c = toupper(c); }
+            sequence = &upper_sequence;
         }
 
+        countRead(seq, *sequence, index, slots);
+
     }
+}
+
 
-    return motif_map;
+void cmri::motifAccumulator::reduce(mapVectorMotifRegion &target) {
+
+    auto target_slots = regionSlots(target);
+    for (size_t slot = 0; slot < slots.size(); slot++) {
+        auto &regions = *slots[slot];
+        for (size_t i = 0; i < regions.size(); i++) {
+            (*target_slots[slot])[i] += regions[i];
+            regions[i].resetCount();
+        }
+    }
+}
+
+
+void cmri::writeCheckpoint(const std::string &file_name, const motif_checkpoint_t &checkpoint,
+                           const mapVectorMotifRegion &motif_map) {
+
+    const std::string tmp_name = file_name + ".tmp";
+    std::ofstream file(tmp_name, std::ios::binary);
+    file.write(checkpoint_magic, sizeof(checkpoint_magic) - 1);
+    writeBinary(file, checkpoint.input_file);
+    writeBinary(file, checkpoint.file_size);
+    writeBinary(file, checkpoint.position);
+    writeBinary(file, checkpoint.reads);
+    writeBinary(file, checkpoint.shard_index);
+    writeBinary(file, checkpoint.shard_count);
+    writeBinary(file, static_cast<uint64_t>(motif_map.size()));
+    for (const auto &item : motif_map) {
+        writeBinary(file, item.first);
+        writeBinary(file, static_cast<uint64_t>(item.second.size()));
+        for (const auto &region : item.second) { region.writeCounts(file); }
+    }
+    file.close();
+
+    if (!file || std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+        LOGGER.warning << "Unable to write checkpoint: " << file_name << std::endl;
+    }
+}
+
+
+bool cmri::readCheckpoint(const std::string &file_name, motif_checkpoint_t &checkpoint,
+                          mapVectorMotifRegion &motif_map) {
+
+    std::ifstream file(file_name, std::ios::binary);
+    if (!file) { return false; }
+
+    std::string magic(sizeof(checkpoint_magic) - 1, ' ');
+    if (!file.read(&magic[0], magic.size()) || magic != checkpoint_magic) { return false; }
+
+    motif_checkpoint_t header;
+    uint64_t keys;
+    if (!readBinary(file, header.input_file) || !readBinary(file, header.file_size) ||
+        !readBinary(file, header.position) || !readBinary(file, header.reads) ||
+        !readBinary(file, header.shard_index) || !readBinary(file, header.shard_count) ||
+        !readBinary(file, keys) || keys != motif_map.size()) { return false; }
+
+    mapVectorMotifRegion restored = motif_map;
+    for (auto &item : restored) {
+        std::string key;
+        uint64_t regions;
+        if (!readBinary(file, key) || key != item.first || !readBinary(file, regions) ||
+            regions != item.second.size()) { return false; }
+        for (auto &region : item.second) {
+            if (!region.readCounts(file)) { return false; }
+        }
+    }
+
+    for (auto &item : motif_map) { item.second.swap(restored[item.first]); }
+    checkpoint = header;
+    return true;
 }
 
 
@@ -175,49 +433,46 @@ void cmri::process(const common_options_t &common_options, const motif_count_opt
 
     cmri::sequenceReader reader(common_options.input_file, motif_count_options.quality_value,
                                 motif_count_options.quality_map);
-    int total_reads = reader.getTotalReads();
-    LOGGER.info << "Processing: " << total_reads << " reads." << std::endl;
+    reader.setShard(common_options.shard_index, common_options.shard_count);
+    if (motif_count_options.indexed) {
+        reader.setRegions(getQueryRegions(motif_map), motif_count_options.unmapped);
+    }
+    reader.setQualityDecoding(motif_count_options.quality_histogram);
+    compileMotifs(motif_map);
+    LOGGER.info << "Processing: " << common_options.input_file << std::endl;
+    resumeRun(common_options, reader, motif_map);
+    const int checkpoint = checkpointInterval(motif_count_options, reader);
+
+    auto index = buildRegionIndex(motif_map, reader.getContigNames());
+    auto slots = regionSlots(motif_map);
 
     cmri::read_item_t read_item;
-    int next_log = common_options.progress;
+    std::string upper_sequence;
+    int next_log = reader.getCount() + common_options.progress;
+    int next_checkpoint = reader.getCount() + checkpoint;
     while (reader.get(read_item)) {
         if (!read_item.valid) { continue; }
 
-        if (motif_map.find(read_item.name) != motif_map.end()) {
-            for (auto &item : motif_map[read_item.name]) {
-
-                if (!item.intersect(read_item.start, read_item.end)) { continue; }
-
-                std::string sequence = read_item.sequence;
-                if (motif_count_options.validate_sequence) { for (auto &c: sequence) { c = toupper(c); }}
-
-
-                searchMotifWFilter(sequence, read_item.qvalue, item.motifs);
-                searchRegex(sequence,read_item.qvalue, item.regex);
-                item.reads_count++;
-                item.total_bases += read_item.sequence.size();
-            }
-        } else {
-            if (motif_map.find("other") != motif_map.end()) {
-
-                std::string sequence = read_item.sequence;
-                if (motif_count_options.validate_sequence) { for (auto &c: sequence) { c = toupper(c); }}
-
-                for (auto &item : motif_map["other"]) {
-                    searchMotifWFilter(sequence, read_item.qvalue, item.motifs);
-                    searchRegex(sequence,read_item.qvalue, item.regex);
-                    item.reads_count++;
-                    item.total_bases += sequence.size();
-                }
-            }
+        const std::string *sequence = &read_item.sequence;
+        if (motif_count_options.validate_sequence) {
+            upper_sequence.assign(read_item.sequence);
+            for (auto &c: upper_sequence) { c = toupper(c); }
+            sequence = &upper_sequence;
         }
 
+        countRead(read_item, *sequence, index, slots);
+
         if (common_options.progress > 0 && reader.getCount() >= next_log) {
-            LOGGER.info << "Progress: " << reader.getCount() << " of " << total_reads << " "
-                        << 100.0 * reader.getCount() / total_reads << "%" << std::endl;
+            LOGGER.info << "Progress: " << reader.getCount() << " reads, "
+                        << 100.0 * reader.getProgress() << "% of the input" << std::endl;
             next_log += common_options.progress;
         }
 
+        if (checkpoint > 0 && reader.getCount() >= next_checkpoint) {
+            saveCheckpoint(common_options, reader, motif_map);
+            next_checkpoint += checkpoint;
+        }
+
     }
     LOGGER.info << "Total sequences analysed: " << reader.getCount() << std::endl;
     reader.close();
@@ -229,64 +484,234 @@ cmri::processMultiThreading(const common_options_t &common_options, const motif_
                             mapVectorMotifRegion &motif_map) {
 
     cmri::sequenceReader reader(common_options.input_file, motif_count_options.quality_value,
-                                motif_count_options.quality_map);
-    int total_reads = reader.getTotalReads();
-    LOGGER.info << "Processing: " << total_reads << " reads." << std::endl;
-
-    std::vector<read_item_t> sequences[common_options.threads];
-
-    cmri::read_item_t read_item;
-    int next_log = common_options.progress;
-    while (reader.get(read_item)) {
-        if (!read_item.valid) { continue; }
+                                motif_count_options.quality_map, common_options.threads);
+    reader.setShard(common_options.shard_index, common_options.shard_count);
+    if (motif_count_options.indexed) {
+        reader.setRegions(getQueryRegions(motif_map), motif_count_options.unmapped);
+    }
+    reader.setQualityDecoding(motif_count_options.quality_histogram);
+    compileMotifs(motif_map);
+    LOGGER.info << "Processing: " << common_options.input_file << std::endl;
+    resumeRun(common_options, reader, motif_map);
+    const int checkpoint = checkpointInterval(motif_count_options, reader);
+
+    //one accumulator per worker for the whole run, reduced into motif_map once every worker is done
+    //(and at every checkpoint).
+    const motifRegionIndex index = buildRegionIndex(motif_map, reader.getContigNames());
+    std::vector<std::unique_ptr<motifAccumulator>> accumulators;
+    for (int i = 0; i < common_options.threads; i++) {
+        accumulators.emplace_back(new motifAccumulator(motif_map, index));
+    }
 
-        sequences[reader.getCount() % common_options.threads].emplace_back(read_item);
+    //Pipeline: reader thread -> filled batches -> worker threads, each counting into its own accumulator.
+    //The queue is bounded, a full queue makes the reader wait, so at most
+    //queue_size + threads + 1 batches of chunk_size reads are in memory.
+    //Idle threads sleep on the condition variables instead of spinning, so they leave the cores to the
+    //bgzf decompression pool.
+    const size_t queue_size = 2 * common_options.threads;
+    readBatchPool batch_pool(std::max(common_options.chunk_size, 1));
+    std::deque<read_batch_t *> filled_batches;
+    std::mutex queue_mutex;
+    std::condition_variable batch_ready;
+    std::condition_variable slot_free;
+    std::condition_variable batch_done;
+    bool reading_done = false;
+    size_t batches_pushed = 0;
+    size_t batches_counted = 0;
+
+    std::thread reader_thread([&]() {
+        int next_log = reader.getCount() + common_options.progress;
+        int next_checkpoint = reader.getCount() + checkpoint;
+        while (true) {
+            read_batch_t *batch = batch_pool.acquire();
+            if (reader.get(*batch) == 0) {
+                batch_pool.release(batch);
+                break;
+            }
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                slot_free.wait(lock, [&]() { return filled_batches.size() < queue_size; });
+                filled_batches.push_back(batch);
+                batches_pushed++;
+            }
+            batch_ready.notify_one();
 
-        if (sequences[common_options.threads - 1].size() > common_options.chunk_size) {
+            if (common_options.progress > 0 && reader.getCount() >= next_log) {
+                LOGGER.info << "Progress: " << reader.getCount() << " reads, "
+                            << 100.0 * reader.getProgress() << "% of the input" << std::endl;
+                while (next_log <= reader.getCount()) { next_log += common_options.progress; }
+            }
 
-            std::vector<std::future<mapVectorMotifRegion  >> pool;
-            for (auto &seq_data : sequences) {
-                pool.push_back(std::async(std::launch::async, &processWorker, motif_map, seq_data,
-                                          motif_count_options.validate_sequence));
-                seq_data.clear();
+            if (checkpoint > 0 && reader.getCount() >= next_checkpoint) {
+                //once every pushed batch is counted the workers are idle and the accumulators can be reduced.
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    batch_done.wait(lock, [&]() { return batches_counted == batches_pushed; });
+                }
+                for (auto &accumulator : accumulators) { accumulator->reduce(motif_map); }
+                saveCheckpoint(common_options, reader, motif_map);
+                while (next_checkpoint <= reader.getCount()) { next_checkpoint += checkpoint; }
             }
-            for (auto &t : pool) {
-                t.wait();
-                for (auto &result : t.get()) {
-                    for (int i = 0; i < result.second.size(); i++) {
-                        motif_map[result.first][i] += result.second[i];
-                    }
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            reading_done = true;
+        }
+        batch_ready.notify_all();
+    });
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < common_options.threads; i++) {
+        workers.emplace_back([&, i]() {
+            while (true) {
+                read_batch_t *batch;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    batch_ready.wait(lock, [&]() { return !filled_batches.empty() || reading_done; });
+                    //the reader pushes its last batch before setting the flag.
+                    if (filled_batches.empty()) { break; }
+                    batch = filled_batches.front();
+                    filled_batches.pop_front();
+                }
+                slot_free.notify_one();
+                accumulators[i]->count(*batch, motif_count_options.validate_sequence);
+                batch_pool.release(batch);
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex);
+                    batches_counted++;
                 }
+                batch_done.notify_one();
             }
+        });
+    }
 
-        }
+    reader_thread.join();
+    for (auto &worker : workers) { worker.join(); }
+    for (auto &accumulator : accumulators) { accumulator->reduce(motif_map); }
 
-        if (common_options.progress > 0 && reader.getCount() >= next_log) {
-            LOGGER.info << "Progress: " << reader.getCount() << " of " << total_reads << " "
-                        << 100.0 * reader.getCount() / total_reads << "%" << std::endl;
-            next_log += common_options.progress;
+    LOGGER.info << "Total sequences analysed: " << reader.getCount() << std::endl;
+    reader.close();
+}
+
+
+std::vector<cmri::bam_partition_t>
+cmri::getPartitions(const std::vector<std::string> &contig_names, const std::vector<int64_t> &contig_lengths,
+                    const mapVectorMotifRegion &motif_map, const motif_count_options_t &motif_count_options) {
+
+    std::vector<bam_partition_t> result;
+    const int64_t tile_size = motif_count_options.partition == "tile" ? motif_count_options.tile_size : 0;
+    for (int32_t tid = 0; tid < static_cast<int32_t>(contig_names.size()); tid++) {
+        if (motif_count_options.indexed && motif_map.find(contig_names[tid]) == motif_map.end()) { continue; }
+        const int64_t length = contig_lengths[tid];
+        if (tile_size <= 0) {
+            result.push_back({tid, 0, length});
+            continue;
+        }
+        for (int64_t begin = 0; begin < length; begin += tile_size) {
+            result.push_back({tid, begin, std::min(begin + tile_size, length)});
         }
+    }
+    //the last tile of a contig also takes reads starting past its declared length.
+    for (size_t i = 0; i < result.size(); i++) {
+        if (i + 1 == result.size() || result[i + 1].tid != result[i].tid) {
+            result[i].end = std::max<int64_t>(result[i].end, std::numeric_limits<int32_t>::max());
+        }
+    }
+    if (!motif_count_options.indexed || motif_count_options.unmapped) { result.push_back({-1, 0, 0}); }
+    return result;
+}
 
 
+void cmri::processPartitions(const common_options_t &common_options,
+                             const motif_count_options_t &motif_count_options, mapVectorMotifRegion &motif_map) {
+
+    std::vector<std::string> contig_names;
+    std::vector<int64_t> contig_lengths;
+    {
+        cmri::sequenceReader reader(common_options.input_file, motif_count_options.quality_value,
+                                    motif_count_options.quality_map);
+        contig_names = reader.getContigNames();
+        contig_lengths = reader.getContigLengths();
+        reader.close();
+    }
+    if (contig_names.empty()) {
+        LOGGER.warning << "Partitions require an indexed bam file, reading the whole input." << std::endl;
+        processMultiThreading(common_options, motif_count_options, motif_map);
+        return;
     }
 
-    std::vector<std::future<mapVectorMotifRegion>> pool;
-    for (auto &seq_data : sequences) {
-        pool.push_back(std::async(std::launch::async, &processWorker, motif_map, seq_data,
-                                  motif_count_options.validate_sequence));
+    if (motif_count_options.checkpoint > 0 || common_options.resume) {
+        LOGGER.warning << "Checkpoints are not supported with partitions, reading the whole input." << std::endl;
     }
-    for (auto &t : pool) {
-        t.wait();
-        for (auto &result : t.get()) {
-            for (int i = 0; i < result.second.size(); i++) {
-                motif_map[result.first][i] += result.second[i];
+
+    compileMotifs(motif_map);
+    const motifRegionIndex index = buildRegionIndex(motif_map, contig_names);
+    const auto partitions = getPartitions(contig_names, contig_lengths, motif_map, motif_count_options);
+    LOGGER.info << "Processing: " << common_options.input_file << " in " << partitions.size() << " partitions"
+                << std::endl;
+
+    std::vector<std::unique_ptr<motifAccumulator>> accumulators;
+    for (int i = 0; i < common_options.threads; i++) {
+        accumulators.emplace_back(new motifAccumulator(motif_map, index));
+    }
+
+    //the logger is not thread safe: workers only record the finished partitions, the main thread reports them.
+    std::mutex progress_mutex;
+    std::condition_variable partition_done;
+    std::vector<size_t> finished_partitions;
+    int running_workers = common_options.threads;
+
+    std::atomic<size_t> next_partition(0);
+    std::atomic<int> total_reads(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < common_options.threads; i++) {
+        workers.emplace_back([&, i]() {
+            cmri::sequenceReader reader(common_options.input_file, motif_count_options.quality_value,
+                                        motif_count_options.quality_map);
+            reader.setQualityDecoding(motif_count_options.quality_histogram);
+            read_batch_t batch(std::max(common_options.chunk_size, 1));
+            size_t p;
+            while ((p = next_partition++) < partitions.size()) {
+                reader.setPartition(partitions[p].tid, partitions[p].begin, partitions[p].end);
+                while (reader.get(batch) > 0) {
+                    accumulators[i]->count(batch, motif_count_options.validate_sequence);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(progress_mutex);
+                    finished_partitions.push_back(p);
+                }
+                partition_done.notify_one();
             }
-        }
+            total_reads += reader.getCount();
+            reader.close();
+            {
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                running_workers--;
+            }
+            partition_done.notify_one();
+        });
     }
 
+    {
+        std::unique_lock<std::mutex> lock(progress_mutex);
+        size_t reported = 0;
+        while (true) {
+            partition_done.wait(lock, [&]() { return finished_partitions.size() > reported || running_workers == 0; });
+            for (; reported < finished_partitions.size(); reported++) {
+                const size_t p = finished_partitions[reported];
+                if (common_options.progress > 0) {
+                    LOGGER.info << "Progress: partition " << p + 1 << " of " << partitions.size() << " done ("
+                                << (partitions[p].tid >= 0 ? contig_names[partitions[p].tid] : "unmapped") << ")"
+                                << std::endl;
+                }
+            }
+            if (running_workers == 0) { break; }
+        }
+    }
+    for (auto &worker : workers) { worker.join(); }
+    for (auto &accumulator : accumulators) { accumulator->reduce(motif_map); }
 
-    LOGGER.info << "Total sequences analysed: " << reader.getCount() << std::endl;
-    reader.close();
+    LOGGER.info << "Total sequences analysed: " << total_reads.load() << std::endl;
 }
 
 
@@ -305,14 +730,29 @@ void cmri::mainMotifCount(const common_options_t &common_options, const motif_co
     }
 
 
-    if (common_options.threads > 1) {
+    if (common_options.shard_count > 1 && (motif_count_options.indexed || motif_count_options.partition != "none")) {
+        cmri::LOGGER.error << "From: " << __FILE__ << ":" << __LINE__ << std::endl;
+        cmri::LOGGER.error << "Invalid argument. Shards cannot be combined with indexed regions or partitions."
+                           << std::endl;
+        exit(EINVAL);
+    }
+
+    if (motif_count_options.partition != "none") {
+        cmri::processPartitions(common_options, motif_count_options, motifs);
+    } else if (common_options.threads > 1) {
         cmri::processMultiThreading(common_options, motif_count_options, motifs);
     } else {
         cmri::process(common_options, motif_count_options, motifs);
     }
 
-    std::ofstream file(common_options.output_path + "/output.json");
-    file << cmri::serialize(motifs);
-    file.close();
+    cmri::jsonWriter output(common_options.output_path + "/output.json", common_options.gzip_output);
+    output.write(motifs);
+    output.close();
+    if (common_options.partial) {
+        cmri::writePartial(common_options.output_path + "/output.partial", partial_t::motif, motifs);
+    }
+
+    //the run is complete, a later --resume starts over.
+    std::remove(checkpointFile(common_options).c_str());
 
 }
@@ -28,9 +28,16 @@
 #include "motifRegion.h"
 #include <regex>
 #include <future>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include "utils.h"
 #include "sequenceReader.h"
 #include "options.h"
+#include "intervalIndex.h"
+#include <limits>
 
 
 namespace cmri {
@@ -39,23 +46,136 @@ namespace cmri {
     unsigned int searchMotif(std::string sequence, const std::string &motif);
 
     //given a DNA seqience string and a vector of phred quality values (per bp) creates a motif occurrence histogram of quality values.
-    void searchMotifWFilter(std::string sequence, std::vector<int> quality, std::map<std::string,std::map<unsigned int,unsigned int>> &motif_quality);
+    void searchMotifWFilter(const std::string &sequence, const std::vector<uint8_t> &quality, std::map<std::string,std::map<unsigned int,unsigned int>> &motif_quality);
+    //same, in a single pass with the automaton of the motifs, hits are added to the histogram row of the motif id.
+    //quality_sum holds the read prefix sums (read_item_t::qsum), so the mean of a hit costs the same at any length.
+    void searchMotifWFilter(const motifMatcher &matcher, const std::string &sequence,
+                            const std::vector<uint32_t> &quality_sum, qvHistogram &histogram);
+    //same with the 2-bit k-mer kernel, for motif sets accepted by kmerMatcher::supports.
+    void searchMotifWFilter(const kmerMatcher &matcher, const std::string &sequence,
+                            const std::vector<uint32_t> &quality_sum, qvHistogram &histogram);
 
     //given a DNA sequence string and a regular expression count the number of occurrences of the given regular expression in the string
     unsigned int searchRegex(std::string sequence, const std::string &regex);
-    void searchRegex(std::string sequence, std::vector<int> quality,
+    void searchRegex(std::string sequence, const std::vector<uint8_t> &quality,
                      std::map<std::string, std::map<unsigned int, unsigned int>> &regex_quality);
+    //same, with compiled regexes and the read prefix sums, hits are added to the histogram row of the regex position.
+    void searchRegex(const std::vector<dnaRegex> &regexes, const std::string &sequence,
+                     const std::vector<uint32_t> &quality_sum, qvHistogram &histogram);
+
+    //hits of the approximate patterns, added to the histogram row of the pattern id.
+    void searchApproximate(const approximateMatcher &matcher, const std::string &sequence,
+                           const std::vector<uint32_t> &quality_sum, qvHistogram &histogram);
+
+    //add the non empty bins of the histogram to a map keyed by pattern (row i is the i-th key).
+    void addHistogram(const qvHistogram &histogram, std::map<std::string, std::map<unsigned int, unsigned int>> &pattern_quality);
 
     //given a DNA sequence string and a regular expression count the number of CONSECUTIVE occurrences of the given regular expression in the string
-    int searchRegexConsecutive(std::string sequence, const std::string &regex);
+    //(each search starts at the last 6 bases of the previous match). Tract lengths are better measured with searchRepeats.
+    int searchRegexConsecutive(const std::string &sequence, const std::string &regex);
+
+    //runs of the repeat units, added to the run length histogram row of the unit id.
+    void searchRepeats(const tandemRepeatMatcher &matcher, const std::string &sequence, runHistogram &histogram);
+
+    //list the regions of the motif file as samtools style queries (contig:start-end), whole contig if start == end.
+    std::vector<std::string> getQueryRegions(const mapVectorMotifRegion &motif_map);
+
+    //build the motif automaton and regexes of the regions created without deserialize.
+    void compileMotifs(mapVectorMotifRegion &motif_map);
+
+    //Regions of a motif map, built once per run. Reads find their contig by bam tid (by name when they have none:
+    //unmapped, qv_fail, mapq_fail, fastq) and their regions through an interval index. A slot is a map key position.
+    struct motifRegionIndex {
+
+        std::vector<int32_t> slot_by_tid; //-1 for contigs without regions
+        std::map<std::string, int32_t> slot_by_name;
+        std::vector<intervalIndex<uint32_t>> regions; //per slot, positions in the contig region vector
+        int32_t other_slot = -1;
+
+        inline int32_t slot(const read_item_t &read) const {
+            if (read.tid >= 0) {
+                return static_cast<size_t>(read.tid) < slot_by_tid.size() ? slot_by_tid[read.tid] : -1;
+            }
+            auto found = slot_by_name.find(read.name);
+            return found != slot_by_name.end() ? found->second : -1;
+        }
+
+    };
+
+    motifRegionIndex buildRegionIndex(const mapVectorMotifRegion &motif_map, const std::vector<std::string> &contig_names);
+
+    //region vectors of the map in slot order.
+    std::vector<vectorMotifRegion *> regionSlots(mapVectorMotifRegion &motif_map);
 
-    mapVectorMotifRegion
-    processWorker(mapVectorMotifRegion motif_map, const std::vector<read_item_t>& sequences, bool validate);
+    //count a read (sequence is the read, upper case if validated) on its regions, or on "other" if it has none.
+    void countRead(const read_item_t &read, const std::string &sequence, const motifRegionIndex &index,
+                   const std::vector<vectorMotifRegion *> &slots);
+
+    //Counts of one worker thread. It keeps its own zeroed copy of the motif map for the whole run,
+    //so batches are counted without copying or merging maps; reduce adds the counts into a map and clears them
+    //(once at the end of the run, or whenever partial totals are needed).
+    class motifAccumulator {
+
+        mapVectorMotifRegion motif_map;
+        const motifRegionIndex &index;
+        std::vector<vectorMotifRegion *> slots;
+        std::string upper_sequence; //validated copy of the current read
+
+    public:
+        motifAccumulator(const mapVectorMotifRegion &_motif_map, const motifRegionIndex &_index);
+
+        motifAccumulator(const motifAccumulator &) = delete;
+        motifAccumulator &operator=(const motifAccumulator &) = delete;
+
+        void count(const read_batch_t &batch, bool validate);
+
+        //target must have the same keys and regions as the map the accumulator was built from.
+        void reduce(mapVectorMotifRegion &target);
+
+    };
+
+    //Partial run saved every motif_count.checkpoint reads: counts so far and the reader position after the last
+    //counted read. The input name and size guard against resuming with another file.
+    struct motif_checkpoint_t {
+        std::string input_file;
+        int64_t file_size = 0;
+        int64_t position = -1;
+        int reads = 0;
+        int shard_index = 0; //positions are only valid in the same shard
+        int shard_count = 1;
+    };
+
+    //write the checkpoint and the counts of the map (binary, in map order). The file is replaced atomically,
+    //an interruption while writing leaves the previous checkpoint.
+    void writeCheckpoint(const std::string &file_name, const motif_checkpoint_t &checkpoint,
+                         const mapVectorMotifRegion &motif_map);
+
+    //read a checkpoint and add its counts to the map, false (map untouched) if the file is missing, damaged
+    //or was written for other regions.
+    bool readCheckpoint(const std::string &file_name, motif_checkpoint_t &checkpoint, mapVectorMotifRegion &motif_map);
 
     void process(const common_options_t &common_options,const motif_count_options_t &motif_count_options, mapVectorMotifRegion &motif_map);
 
     void processMultiThreading(const common_options_t &common_options,const motif_count_options_t &motif_count_options, mapVectorMotifRegion &motif_map);
 
+    //Reads of an indexed bam starting in [begin, end) of contig tid, or the reads without coordinates (tid < 0).
+    struct bam_partition_t {
+        int32_t tid;
+        int64_t begin;
+        int64_t end;
+    };
+
+    //Partitions covering the input in file order: whole contigs, or tiles of tile_size for partition == "tile",
+    //then the reads without coordinates. With indexed, only contigs of the motif map (and unmapped if requested).
+    std::vector<bam_partition_t> getPartitions(const std::vector<std::string> &contig_names,
+                                               const std::vector<int64_t> &contig_lengths,
+                                               const mapVectorMotifRegion &motif_map,
+                                               const motif_count_options_t &motif_count_options);
+
+    //Every thread owns a reader (its own samFile) and an accumulator, and takes the next partition until none is
+    //left. Accumulators are reduced in thread order at the end.
+    void processPartitions(const common_options_t &common_options,const motif_count_options_t &motif_count_options, mapVectorMotifRegion &motif_map);
+
     void mainMotifCount(const common_options_t &common_options, const motif_count_options_t &motif_count_options);
 
 
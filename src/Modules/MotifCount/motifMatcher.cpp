@@ -0,0 +1,93 @@
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "motifMatcher.h"
+#include <algorithm>
+#include <queue>
+
+
+cmri::motifMatcher::motifMatcher(const std::vector<std::string> &_patterns) : patterns(_patterns) {
+
+    //byte classes, 0 is any byte not used by the motifs.
+    std::fill(byte_class, byte_class + 256, 0);
+    n_classes = 1;
+    for (auto &pattern : patterns) {
+        for (auto c : pattern) {
+            auto &b = byte_class[static_cast<uint8_t>(c)];
+            if (b == 0) { b = n_classes++; }
+        }
+    }
+
+    //trie, -1 for a missing edge.
+    std::vector<int32_t> trie(n_classes, -1);
+    std::vector<std::vector<int32_t>> terminal(1);
+    for (size_t id = 0; id < patterns.size(); id++) {
+        lengths.push_back(patterns[id].size());
+        if (patterns[id].empty()) { continue; } //would match everywhere
+        int32_t state = 0;
+        for (auto c : patterns[id]) {
+            int32_t &next = trie[state * n_classes + byte_class[static_cast<uint8_t>(c)]];
+            if (next < 0) {
+                next = static_cast<int32_t>(terminal.size());
+                terminal.emplace_back();
+                trie.resize(trie.size() + n_classes, -1);
+            }
+            state = trie[state * n_classes + byte_class[static_cast<uint8_t>(c)]];
+        }
+        terminal[state].push_back(id);
+    }
+
+    //breadth first: failure links and the complete transition table, outputs include those of the failure state.
+    const auto n_states = static_cast<int32_t>(terminal.size());
+    transition.assign(n_states * n_classes, 0);
+    std::vector<int32_t> fail(n_states, 0);
+    std::vector<std::vector<int32_t>> output(n_states);
+    std::queue<int32_t> pending;
+    pending.push(0);
+    while (!pending.empty()) {
+        int32_t state = pending.front();
+        pending.pop();
+        output[state] = terminal[state];
+        if (state != 0) {
+            output[state].insert(output[state].end(), output[fail[state]].begin(), output[fail[state]].end());
+        }
+        for (int32_t c = 0; c < n_classes; c++) {
+            int32_t next = trie[state * n_classes + c];
+            int32_t fallback = state == 0 ? 0 : transition[fail[state] * n_classes + c];
+            if (next < 0) {
+                transition[state * n_classes + c] = fallback;
+            } else {
+                transition[state * n_classes + c] = next;
+                fail[next] = fallback;
+                pending.push(next);
+            }
+        }
+    }
+
+    output_offset.assign(n_states + 1, 0);
+    for (int32_t state = 0; state < n_states; state++) {
+        output_offset[state + 1] = output_offset[state] + static_cast<int32_t>(output[state].size());
+        output_ids.insert(output_ids.end(), output[state].begin(), output[state].end());
+    }
+
+}
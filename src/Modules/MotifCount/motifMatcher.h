@@ -0,0 +1,71 @@
+#ifndef GEAR_MOTIFMATCHER_H
+#define GEAR_MOTIFMATCHER_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cmri {
+
+    //Aho-Corasick automaton over a set of literal motifs.
+    //One pass over a sequence reports every occurrence of every motif, so the cost per read does not depend on the
+    //number of motifs. Bytes that do not appear in any motif share a single class to keep the transition table small.
+    class motifMatcher {
+
+        std::vector<std::string> patterns;
+        std::vector<int32_t> lengths;
+        uint8_t byte_class[256];
+        int32_t n_classes;
+        std::vector<int32_t> transition; //state * n_classes + byte class -> state
+        std::vector<int32_t> output_offset; //motifs ending at state s: output_ids[output_offset[s]..output_offset[s+1])
+        std::vector<int32_t> output_ids;
+
+    public:
+
+        explicit motifMatcher(const std::vector<std::string> &_patterns);
+
+        inline size_t size() const { return patterns.size(); }
+
+        inline const std::string &getPattern(size_t id) const { return patterns[id]; }
+
+        //calls on_match(motif id, start position) for every occurrence, ordered by end position.
+        template<class F>
+        inline void scan(const std::string &sequence, F on_match) const {
+            int32_t state = 0;
+            const size_t length = sequence.size();
+            for (size_t i = 0; i < length; i++) {
+                state = transition[state * n_classes + byte_class[static_cast<uint8_t>(sequence[i])]];
+                for (int32_t k = output_offset[state]; k < output_offset[state + 1]; k++) {
+                    int32_t id = output_ids[k];
+                    on_match(id, i + 1 - lengths[id]);
+                }
+            }
+        }
+
+    };
+
+}
+
+#endif //GEAR_MOTIFMATCHER_H
@@ -22,33 +22,64 @@
 //
 
 #include "motifRegion.h"
+#include "utils.h"
+#include <set>
 
 
-std::string cmri::motifRegion::serialize() const {
-    std::stringstream result;
+void cmri::motifRegion::serialize(std::ostream &result) const {
     result << "{";
     result << "\"start\":" << start;
     result << ",\"end\":" << end;
     result << ",\"name\":\"" << name << "\"";
     result << ",\"count\":" << reads_count;
     result << ",\"total_bases\":" << total_bases;
+    if (strand_aware) { result << ",\"strand_aware\":true"; }
+
+    //forward and reverse rows of strand aware patterns.
+    auto patternCounts = [&](const std::vector<std::string> &names, const auto &counts) {
+        for (size_t id = 0; id < names.size(); id++) {
+            result << "\"" << names[id] << "\" : ";
+            if (strand_aware) {
+                result << "{\"forward\":";
+                counts.serialize(result, id);
+                result << ",\"reverse\":";
+                counts.serialize(result, names.size() + id);
+                result << "}";
+            } else {
+                counts.serialize(result, id);
+            }
+            result << (id < names.size() - 1 ? "," : "");
+        }
+    };
 
     result << ",\"motifs\":{";
-    for(auto iter_data = motifs.begin(); iter_data != motifs.end(); ++iter_data) {
-        result << "\"" << iter_data->first <<"\" : " << cmri::serialize(iter_data->second);
-        result << (std::next(iter_data) != motifs.end() ? "," : "");
-    }
+    patternCounts(motifs, motif_counts);
     result << "}";
 
     result << ",\"regex\":{";
-    for(auto iter_data = regex.begin(); iter_data != regex.end(); ++iter_data) {
-        result << "\"" << iter_data->first <<"\" : " << cmri::serialize(iter_data->second);
-        result << (std::next(iter_data) != regex.end() ? "," : "");
+    for(size_t id = 0; id < regex.size(); id++) {
+        result << "\"" << regex[id] <<"\" : ";
+        regex_counts.serialize(result, id);
+        result << (id < regex.size() - 1 ? "," : "");
     }
     result << "}";
 
+    if (!approximate.empty()) {
+        result << ",\"distance\":\"" << (distance == distanceType::edit ? "edit" : "hamming") << "\"";
+        result << ",\"max_distance\":" << max_distance;
+        result << ",\"approximate\":{";
+        patternCounts(approximate, approximate_counts);
+        result << "}";
+    }
+
+    if (!repeats.empty()) {
+        result << ",\"min_repeats\":" << min_repeats;
+        result << ",\"repeats\":{";
+        patternCounts(repeats, repeat_counts);
+        result << "}";
+    }
+
     result << "}";
-    return result.str();
 }
 
 void cmri::motifRegion::deserialize(const boost::property_tree::ptree &tree) {
@@ -56,37 +87,43 @@ void cmri::motifRegion::deserialize(const boost::property_tree::ptree &tree) {
         genomeRegion::deserialize(tree);
         reads_count = tree.get<unsigned int>("count");
         total_bases = tree.get<unsigned int>("total_bases");
+        strand_aware = tree.get<bool>("strand_aware", false);
 
-        for(auto &item : tree.get_child("motifs")){
-            std::map<unsigned int, unsigned int> values;
-            for(auto &child_item : item.second){
-                values[std::stoi(child_item.first)]=child_item.second.get_value<unsigned int>();
-            }
-            motifs[item.first]=values;
+        //counts always start at zero, only the pattern names are read.
+        std::set<std::string> motif_names;
+        for(auto &item : tree.get_child("motifs")){ motif_names.insert(item.first); }
+        motifs.assign(motif_names.begin(), motif_names.end());
+        motif_counts.resize(motifPatterns().size());
+
+        std::set<std::string> regex_names;
+        for(auto &item : tree.get_child("regex")){ regex_names.insert(item.first); }
+        regex.assign(regex_names.begin(), regex_names.end());
+        regex_counts.resize(regex.size());
+
+        std::set<std::string> approximate_names;
+        auto approximate_tree = tree.get_child_optional("approximate");
+        if (approximate_tree) {
+            for (auto &item : *approximate_tree) { approximate_names.insert(item.first); }
         }
-        //TODO: try to make use of template
-        //cmri::deserialize(tree.get_child("motif_quality"), motif_quality);
-        for (auto &mq : motifs) {
-            for (int i = 0; i < 100; i++) {
-                mq.second[i] = 0;
-            }
+        approximate.assign(approximate_names.begin(), approximate_names.end());
+        auto distance_name = tree.get<std::string>("distance", "hamming");
+        if (distance_name != "hamming" && distance_name != "edit") {
+            throw std::invalid_argument("distance must be hamming or edit, found " + distance_name);
         }
+        distance = distance_name == "edit" ? distanceType::edit : distanceType::hamming;
+        max_distance = tree.get<int32_t>("max_distance", 1);
+        approximate_counts.resize(approximatePatterns().size());
 
-        for(auto &item : tree.get_child("regex")){
-            std::map<unsigned int, unsigned int> values;
-            for(auto &child_item : item.second){
-                values[std::stoi(child_item.first)]=child_item.second.get_value<unsigned int>();
-            }
-            regex[item.first]=values;
-        }
-        //TODO: try to make use of template
-        //cmri::deserialize(tree.get_child("motif_quality"), motif_quality);
-        for (auto &r : regex) {
-            for (int i = 0; i < 100; i++) {
-                r.second[i] = 0;
-            }
+        std::set<std::string> repeat_names;
+        auto repeat_tree = tree.get_child_optional("repeats");
+        if (repeat_tree) {
+            for (auto &item : *repeat_tree) { repeat_names.insert(item.first); }
         }
+        repeats.assign(repeat_names.begin(), repeat_names.end());
+        min_repeats = tree.get<uint32_t>("min_repeats", 2);
+        repeat_counts.resize(repeatPatterns().size());
 
+        compile();
 
     }
     catch (std::exception &e) {
@@ -96,3 +133,152 @@ void cmri::motifRegion::deserialize(const boost::property_tree::ptree &tree) {
     }
 }
 
+void cmri::motifRegion::writeCounts(std::ostream &out) const {
+    writeBinary(out, start);
+    writeBinary(out, end);
+    writeBinary(out, static_cast<uint64_t>(motif_counts.counts.size()));
+    writeBinary(out, static_cast<uint64_t>(regex_counts.counts.size()));
+    writeBinary(out, static_cast<uint64_t>(approximate_counts.counts.size()));
+    writeBinary(out, reads_count);
+    writeBinary(out, total_bases);
+    out.write(reinterpret_cast<const char *>(motif_counts.counts.data()),
+              motif_counts.counts.size() * sizeof(unsigned int));
+    out.write(reinterpret_cast<const char *>(regex_counts.counts.data()),
+              regex_counts.counts.size() * sizeof(unsigned int));
+    out.write(reinterpret_cast<const char *>(approximate_counts.counts.data()),
+              approximate_counts.counts.size() * sizeof(unsigned int));
+    //sparse run lengths: entries per unit, then (length, runs) pairs.
+    writeBinary(out, static_cast<uint64_t>(repeat_counts.patterns()));
+    for (auto &unit : repeat_counts.counts) {
+        writeBinary(out, static_cast<uint64_t>(unit.size()));
+        for (auto &item : unit) {
+            writeBinary(out, item.first);
+            writeBinary(out, item.second);
+        }
+    }
+}
+
+bool cmri::motifRegion::readCounts(std::istream &in) {
+    unsigned int region_start, region_end, reads, bases;
+    uint64_t motif_size, regex_size, approximate_size;
+    if (!readBinary(in, region_start) || !readBinary(in, region_end) || !readBinary(in, motif_size) ||
+        !readBinary(in, regex_size) || !readBinary(in, approximate_size) || !readBinary(in, reads) ||
+        !readBinary(in, bases)) { return false; }
+    if (region_start != start || region_end != end || motif_size != motif_counts.counts.size() ||
+        regex_size != regex_counts.counts.size() || approximate_size != approximate_counts.counts.size()) {
+        return false;
+    }
+
+    std::vector<unsigned int> counts(motif_size + regex_size + approximate_size);
+    if (!in.read(reinterpret_cast<char *>(counts.data()), counts.size() * sizeof(unsigned int))) { return false; }
+
+    uint64_t repeat_size;
+    if (!readBinary(in, repeat_size) || repeat_size != repeat_counts.patterns()) { return false; }
+    runHistogram runs;
+    runs.resize(repeat_size);
+    for (auto &unit : runs.counts) {
+        uint64_t entries;
+        if (!readBinary(in, entries)) { return false; }
+        for (uint64_t i = 0; i < entries; i++) {
+            uint32_t length, number;
+            if (!readBinary(in, length) || !readBinary(in, number)) { return false; }
+            unit[length] = number;
+        }
+    }
+
+    for (size_t i = 0; i < motif_size; i++) { motif_counts.counts[i] += counts[i]; }
+    for (size_t i = 0; i < regex_size; i++) { regex_counts.counts[i] += counts[motif_size + i]; }
+    for (size_t i = 0; i < approximate_size; i++) {
+        approximate_counts.counts[i] += counts[motif_size + regex_size + i];
+    }
+    repeat_counts += runs;
+    reads_count += reads;
+    total_bases += bases;
+    return true;
+}
+
+void cmri::motifRegion::writePartial(std::ostream &out) const {
+    writeBinary(out, start);
+    writeBinary(out, end);
+    writeBinary(out, name);
+    writeBinary(out, strand_aware);
+    writeBinary(out, distance);
+    writeBinary(out, max_distance);
+    writeBinary(out, min_repeats);
+    writeBinary(out, motifs);
+    writeBinary(out, regex);
+    writeBinary(out, approximate);
+    writeBinary(out, repeats);
+    writeCounts(out);
+}
+
+bool cmri::motifRegion::readPartial(std::istream &in) {
+    if (!readBinary(in, start) || !readBinary(in, end) || !readBinary(in, name) || !readBinary(in, strand_aware) ||
+        !readBinary(in, distance) || !readBinary(in, max_distance) || !readBinary(in, min_repeats) ||
+        !readBinary(in, motifs) || !readBinary(in, regex) || !readBinary(in, approximate) ||
+        !readBinary(in, repeats)) { return false; }
+
+    motif_counts.resize(motifPatterns().size());
+    regex_counts.resize(regex.size());
+    approximate_counts.resize(approximatePatterns().size());
+    repeat_counts.resize(repeatPatterns().size());
+    reads_count = 0;
+    total_bases = 0;
+    return readCounts(in);
+}
+
+std::vector<std::string> cmri::motifRegion::motifPatterns() const {
+    std::vector<std::string> patterns = motifs;
+    if (strand_aware) {
+        for (auto &motif : motifs) { patterns.push_back(reverse_complement(motif)); }
+    }
+    return patterns;
+}
+
+std::vector<std::string> cmri::motifRegion::repeatPatterns() const {
+    std::vector<std::string> patterns = repeats;
+    if (strand_aware) {
+        for (auto &unit : repeats) { patterns.push_back(reverse_complement(unit)); }
+    }
+    return patterns;
+}
+
+std::vector<std::string> cmri::motifRegion::approximatePatterns() const {
+    std::vector<std::string> patterns = approximate;
+    if (strand_aware) {
+        for (auto &pattern : approximate) { patterns.push_back(reverse_complement(pattern)); }
+    }
+    return patterns;
+}
+
+void cmri::motifRegion::compile() {
+    auto patterns = motifPatterns();
+    motif_matcher = std::make_shared<const motifMatcher>(patterns);
+    kmer_matcher.reset();
+    if (!patterns.empty() && kmerMatcher::supports(patterns)) {
+        kmer_matcher = std::make_shared<const kmerMatcher>(patterns);
+    }
+
+    auto regex_list = std::make_shared<std::vector<dnaRegex>>();
+    for (auto &r : regex) { regex_list->emplace_back(r); }
+    regex_matcher = regex_list;
+
+    auto approximate_patterns = approximatePatterns();
+    approximate_matcher.reset();
+    if (!approximate_patterns.empty()) {
+        approximate_matcher = std::make_shared<const approximateMatcher>(approximate_patterns, distance, max_distance);
+    }
+
+    auto repeat_patterns = repeatPatterns();
+    repeat_matcher.reset();
+    if (!repeat_patterns.empty()) {
+        repeat_matcher = std::make_shared<const tandemRepeatMatcher>(repeat_patterns, min_repeats);
+    }
+
+    if (motif_counts.patterns() != patterns.size()) { motif_counts.resize(patterns.size()); }
+    if (regex_counts.patterns() != regex.size()) { regex_counts.resize(regex.size()); }
+    if (approximate_counts.patterns() != approximate_patterns.size()) {
+        approximate_counts.resize(approximate_patterns.size());
+    }
+    if (repeat_counts.patterns() != repeat_patterns.size()) { repeat_counts.resize(repeat_patterns.size()); }
+}
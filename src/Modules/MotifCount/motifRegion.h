@@ -27,7 +27,16 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <genomeRegion.h>
 #include "logger.h"
+#include "partialResult.h"
+#include "motifMatcher.h"
+#include "kmerMatcher.h"
+#include "approximateMatcher.h"
+#include "tandemRepeatMatcher.h"
+#include "dnaRegex.h"
+#include "qvHistogram.h"
+#include "runHistogram.h"
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -39,15 +48,69 @@ namespace cmri{
         unsigned int reads_count=0;
         unsigned int total_bases=0;
 
-        std::map<std::string,std::map<unsigned int,unsigned int>> motifs;
-        std::map<std::string,std::map<unsigned int,unsigned int>> regex;
-
-        std::string serialize() const override;
+        //pattern names in alphabetical order (as deserialized), a pattern id is its position in these lists.
+        std::vector<std::string> motifs;
+        std::vector<std::string> regex;
+        std::vector<std::string> approximate; //counted within max_distance differences
+        std::vector<std::string> repeats; //units of tandem repeat runs
+
+        //"distance" and "max_distance" in the json, shared by the approximate patterns of the region.
+        distanceType distance = distanceType::hamming;
+        int32_t max_distance = 1;
+
+        //"min_repeats" in the json: shortest run (copies of the unit) added to the run length histogram.
+        uint32_t min_repeats = 2;
+
+        //"strand_aware" in the json: the reverse complement of every motif is searched in the same scan,
+        //its hits go to row motifs.size() + id of motif_counts and are reported as the reverse strand.
+        //Approximate patterns and repeat units are handled the same way.
+        bool strand_aware = false;
+
+        //hits per pattern id and quality bin.
+        qvHistogram motif_counts;
+        qvHistogram regex_counts;
+        qvHistogram approximate_counts;
+        runHistogram repeat_counts; //runs per repeat unit and length
+
+        //built from motifs and regex by compile, shared by the copies of the region.
+        std::shared_ptr<const motifMatcher> motif_matcher;
+        std::shared_ptr<const kmerMatcher> kmer_matcher; //null unless every motif is a short A,C,G,T literal
+        std::shared_ptr<const std::vector<dnaRegex>> regex_matcher;
+        std::shared_ptr<const approximateMatcher> approximate_matcher; //null without approximate patterns
+        std::shared_ptr<const tandemRepeatMatcher> repeat_matcher; //null without repeat units
+
+        using genomeRegion::serialize;
+        void serialize(std::ostream &result) const override;
          void deserialize(const boost::property_tree::ptree &tree) override;
 
+        void compile();
+
+        //counts in binary form (checkpoints), after the region coordinates and pattern numbers used to check them.
+        void writeCounts(std::ostream &out) const;
+
+        //add counts written by writeCounts, false (nothing added) if they belong to another region or pattern list.
+        bool readCounts(std::istream &in);
+
+        //region definition and counts (partial results, see the Merge task).
+        void writePartial(std::ostream &out) const;
+
+        //replace the region by one written by writePartial, the matchers are not compiled.
+        bool readPartial(std::istream &in);
+
+        //patterns searched for the motifs: the motifs, followed by their reverse complements when strand aware.
+        std::vector<std::string> motifPatterns() const;
+
+        //same for the approximate patterns.
+        std::vector<std::string> approximatePatterns() const;
+
+        //same for the repeat units.
+        std::vector<std::string> repeatPatterns() const;
+
         inline void resetCount(){
-            for(auto &mq : motifs){for(auto &m : mq.second){ m.second=0;}}
-            for(auto &r : regex){for(auto &rr : r.second){rr.second=0;}}
+            motif_counts.reset();
+            regex_counts.reset();
+            approximate_counts.reset();
+            repeat_counts.reset();
             reads_count=0;
             total_bases=0;
         }
@@ -60,18 +123,14 @@ namespace cmri{
         }
 
 
-        void operator+=(motifRegion &rhs)  {
-            if(genomeRegion::operator==(rhs)){
-                for(auto &mq : motifs){
-                    for(auto &m : mq.second){
-                        m.second+=rhs.motifs[mq.first][m.first];
-                    }
-                }
-                for(auto &r : regex){
-                    for(auto &rr : r.second){
-                        rr.second+=rhs.regex[r.first][rr.first];
-                    }
-                }
+        void operator+=(const motifRegion &rhs)  {
+            if(genomeRegion::operator==(rhs) && motifs == rhs.motifs && regex == rhs.regex &&
+               approximate == rhs.approximate && repeats == rhs.repeats && strand_aware == rhs.strand_aware &&
+               distance == rhs.distance && max_distance == rhs.max_distance && min_repeats == rhs.min_repeats){
+                motif_counts += rhs.motif_counts;
+                regex_counts += rhs.regex_counts;
+                approximate_counts += rhs.approximate_counts;
+                repeat_counts += rhs.repeat_counts;
                 reads_count += rhs.reads_count;
                 total_bases+= rhs.total_bases;
             }
@@ -85,7 +144,7 @@ namespace cmri{
 
     inline std::ostream& operator<<(std::ostream& result, const motifRegion& rhs)
     {
-        result << rhs.serialize();
+        rhs.serialize(result);
         return result;
     }
 
@@ -0,0 +1,77 @@
+#ifndef GEAR_QVHISTOGRAM_H
+#define GEAR_QVHISTOGRAM_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cmri {
+
+    //Hit counts per pattern and quality bin in one contiguous block, row pattern_id holds the bins of that pattern.
+    struct qvHistogram {
+
+        static const unsigned int bins = 100; //phred 0-99
+
+        std::vector<unsigned int> counts;
+
+        inline void resize(size_t patterns) { counts.assign(patterns * bins, 0); }
+
+        inline size_t patterns() const { return counts.size() / bins; }
+
+        inline void add(size_t pattern, unsigned int qv) { counts[pattern * bins + qv]++; }
+
+        inline unsigned int get(size_t pattern, unsigned int qv) const { return counts[pattern * bins + qv]; }
+
+        inline void reset() { std::fill(counts.begin(), counts.end(), 0); }
+
+        inline void operator+=(const qvHistogram &rhs) {
+            if (counts.size() != rhs.counts.size()) { throw std::runtime_error("error histograms do not match "); }
+            for (size_t i = 0; i < counts.size(); i++) { counts[i] += rhs.counts[i]; }
+        }
+
+        inline bool operator==(const qvHistogram &rhs) const { return counts == rhs.counts; }
+
+        //bins of one pattern as a json object {"0":n,...,"99":n}
+        void serialize(std::ostream &result, size_t pattern) const {
+            result << "{";
+            for (unsigned int qv = 0; qv < bins; qv++) {
+                result << "\"" << qv << "\":" << get(pattern, qv) << (qv < bins - 1 ? "," : "");
+            }
+            result << "}";
+        }
+
+        std::string serialize(size_t pattern) const {
+            std::stringstream result;
+            serialize(result, pattern);
+            return result.str();
+        }
+
+    };
+
+}
+
+#endif //GEAR_QVHISTOGRAM_H
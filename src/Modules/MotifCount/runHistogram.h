@@ -0,0 +1,84 @@
+#ifndef GEAR_RUNHISTOGRAM_H
+#define GEAR_RUNHISTOGRAM_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cmri {
+
+    //Repeat runs per pattern and run length (copies of the unit). Sparse, telomeric tracts of long reads reach
+    //thousands of copies.
+    struct runHistogram {
+
+        std::vector<std::map<uint32_t, uint32_t>> counts; //per pattern, run length -> runs
+
+        inline void resize(size_t patterns) { counts.assign(patterns, {}); }
+
+        inline size_t patterns() const { return counts.size(); }
+
+        inline void add(size_t pattern, uint32_t units) { counts[pattern][units]++; }
+
+        inline uint32_t get(size_t pattern, uint32_t units) const {
+            auto found = counts[pattern].find(units);
+            return found != counts[pattern].end() ? found->second : 0;
+        }
+
+        inline void reset() { for (auto &pattern : counts) { pattern.clear(); } }
+
+        inline void operator+=(const runHistogram &rhs) {
+            if (counts.size() != rhs.counts.size()) { throw std::runtime_error("error histograms do not match "); }
+            for (size_t i = 0; i < counts.size(); i++) {
+                for (auto &item : rhs.counts[i]) { counts[i][item.first] += item.second; }
+            }
+        }
+
+        inline bool operator==(const runHistogram &rhs) const { return counts == rhs.counts; }
+
+        //run lengths of one pattern as a json object {"length":n,...}, only lengths seen.
+        void serialize(std::ostream &result, size_t pattern) const {
+            result << "{";
+            bool first = true;
+            for (auto &item : counts[pattern]) {
+                result << (first ? "" : ",") << "\"" << item.first << "\":" << item.second;
+                first = false;
+            }
+            result << "}";
+        }
+
+        std::string serialize(size_t pattern) const {
+            std::stringstream result;
+            serialize(result, pattern);
+            return result.str();
+        }
+
+    };
+
+}
+
+#endif //GEAR_RUNHISTOGRAM_H
@@ -0,0 +1,41 @@
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+
+#include "tandemRepeatMatcher.h"
+#include <algorithm>
+#include <stdexcept>
+
+
+cmri::tandemRepeatMatcher::tandemRepeatMatcher(const std::vector<std::string> &_units, uint32_t _min_units)
+        : units(_units), min_units(std::max<uint32_t>(_min_units, 1)) {
+
+    phase_offset.push_back(0);
+    for (auto &unit : units) {
+        if (unit.empty()) { throw std::invalid_argument("empty repeat unit"); }
+        phase_offset.push_back(phase_offset.back() + unit.size());
+    }
+    motif_matcher = std::make_shared<const motifMatcher>(units);
+    if (!units.empty() && kmerMatcher::supports(units)) { kmer_matcher = std::make_shared<const kmerMatcher>(units); }
+}
@@ -0,0 +1,119 @@
+#ifndef GEAR_TANDEMREPEATMATCHER_H
+#define GEAR_TANDEMREPEATMATCHER_H
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "motifMatcher.h"
+#include "kmerMatcher.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cmri {
+
+    //Maximal runs of consecutive copies of repeat units (TTAGGGTTAGGG... is one run of TTAGGG), in a single linear
+    //pass: the unit occurrences come from one automaton scan, and each occurrence either extends the open run of its
+    //unit and phase (start modulo the unit length, it starts where the run ends) or closes it and opens a new one.
+    //Units whose copies overlap each other (AA, ATA) can give overlapping runs in different phases, the longest of
+    //them is reported, so the runs of a unit do not overlap, as the motif hits do.
+    class tandemRepeatMatcher {
+
+        struct run_t {
+            size_t start = 0;
+            size_t end = 0; //next copy of the unit starts here
+            uint32_t units = 0;
+        };
+
+        std::vector<std::string> units;
+        std::vector<size_t> phase_offset; //open run of unit id and phase p: phase_offset[id] + p
+        std::shared_ptr<const motifMatcher> motif_matcher;
+        std::shared_ptr<const kmerMatcher> kmer_matcher; //null unless kmerMatcher::supports the units
+        uint32_t min_units;
+
+    public:
+
+        //runs shorter than _min_units copies are not reported.
+        tandemRepeatMatcher(const std::vector<std::string> &_units, uint32_t _min_units);
+
+        inline size_t size() const { return units.size(); }
+
+        inline const std::string &getUnit(size_t id) const { return units[id]; }
+
+        //calls on_run(unit id, start position, number of copies) for every run, ordered by start position for each unit.
+        template<class F>
+        inline void scan(const std::string &sequence, F on_run) const {
+            thread_local std::vector<run_t> open;
+            thread_local std::vector<std::pair<int32_t, run_t>> closed;
+            open.assign(phase_offset.back(), run_t());
+            closed.clear();
+
+            auto occurrence = [&](int32_t id, size_t start) {
+                const size_t length = units[id].size();
+                auto &run = open[phase_offset[id] + start % length];
+                if (run.units > 0) {
+                    if (start == run.end) {
+                        run.end += length;
+                        run.units++;
+                        return;
+                    }
+                    closed.emplace_back(id, run);
+                }
+                run.start = start;
+                run.end = start + length;
+                run.units = 1;
+            };
+
+            if (kmer_matcher) {
+                kmer_matcher->scan(sequence, occurrence);
+            } else {
+                motif_matcher->scan(sequence, occurrence);
+            }
+            for (size_t id = 0; id < units.size(); id++) {
+                for (size_t phase = phase_offset[id]; phase < phase_offset[id + 1]; phase++) {
+                    if (open[phase].units > 0) { closed.emplace_back(static_cast<int32_t>(id), open[phase]); }
+                }
+            }
+
+            std::sort(closed.begin(), closed.end(),
+                      [](const std::pair<int32_t, run_t> &lhs, const std::pair<int32_t, run_t> &rhs) {
+                          return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second.start < rhs.second.start);
+                      });
+            //of the runs of a unit overlapping each other, the one with most copies (the first on ties).
+            size_t i = 0;
+            while (i < closed.size()) {
+                auto best = closed[i++];
+                while (i < closed.size() && closed[i].first == best.first && closed[i].second.start < best.second.end) {
+                    if (closed[i].second.units > best.second.units) { best = closed[i]; }
+                    i++;
+                }
+                if (best.second.units >= min_units) { on_run(best.first, best.second.start, best.second.units); }
+            }
+        }
+
+    };
+
+}
+
+#endif //GEAR_TANDEMREPEATMATCHER_H
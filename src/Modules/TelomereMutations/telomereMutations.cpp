@@ -10,10 +10,216 @@
 #include "minimap.h"
 #include "kseq.h"
 #include <cmath>
+#include "jsonWriter.h"
+#include "orderedPipeline.h"
 
 KSEQ_INIT(gzFile, gzread)
 
+namespace {
+
+    struct query_read_t {
+        std::string name;
+        std::string comment;
+        std::string sequence;
+        std::string quality;
+    };
+
+    struct mapped_read_t {
+        cmri::mutations_t mutations;
+        std::string error;
+    };
+
+    //best hit of the read in the index part, false (mut.score == 0) if the read does not map.
+    //Runs on the mapping workers: tbuf is the minimap2 buffer of the calling thread, and nothing is logged here
+    //(the logger is not thread safe), errors are returned in error.
+    bool mapRead(const mm_idx_t *mi, const mm_mapopt_t &mopt, mm_tbuf_t *tbuf, const query_read_t &read,
+                 const std::vector<char> &wt_motif, const cmri::telomere_mutations_options_t &options,
+                 cmri::mutations_t &mut, std::string &error) {
+
+        using namespace cmri;
+        const int wt_size = wt_motif.size();
+        const int length = read.sequence.size();
+        mut.score = 0;
+
+        mm_reg1_t *reg;
+        int j, n_reg;
+        reg = mm_map(mi, length, read.sequence.c_str(), &n_reg, tbuf, &mopt, 0); // get all hits for the query
+
+        for (j = 0; j < n_reg; ++j) { // traverse hits and print them out
+            mm_reg1_t *r = &reg[j];
+            assert(r->p); // with MM_F_CIGAR, this should not be NULL
+
+            void *km = nullptr;
+            char *cs_str = NULL;
+            int max_len = 0;
+            mm_gen_cs(km, &cs_str, &max_len, mi, r, read.sequence.c_str(), true);
+
+            auto cm_tag = parseTag(cs_str,r->rev);
+            std::map<int, std::vector<sbs_t>> sbs;
+            std::map<int, std::vector<indel_t>> indels;
+
+            int rs = r->rs;
+            int re = r->re;
+            int qs = r->qs;
+            int qe = r->qe;
+            std::string que;
+            std::string qv_str;
+            std::vector<int> qv;
+            if(r->rev){
+                qs = length - r->qe;
+                qe = length - r->qs;
+                for (int i = static_cast<int>(read.quality.size())-1; i >= 0 ; i--) {
+                    qv.push_back(static_cast<int>(read.quality[i]) - 33);
+                }
+                que=reverse_complement(read.sequence);
+                qv_str = reverse_string(read.quality);
+            }
+            else{
+                for (size_t i = 0; i < read.quality.size(); i++) {
+                    qv.push_back(static_cast<int>(read.quality[i]) - 33);
+                }
+                que = read.sequence;
+                qv_str = read.quality;
+            }
+
+
+            int size;
+            for (auto &item : cm_tag) {
+                switch (item.first) {
+                    case ':':
+                        size = std::stoi(item.second);
+                        rs += size;
+                        qs += size;
+                        break;
+                    case '-':
+                    case '+': {
+                        size = item.second.size();
+                        double sum = 0;
+                        for (int i = qs; i < qs + size; i++) { sum += qv[i]; }
+                        std::string kind = item.first == '-' ? "del" : "ins";
+                        indel_t indel;
+                        indel.kind = kind;
+                        indel.pos = rs%wt_size;
+                        indel.seq = item.second;
+                        indel.mean_qv = sum/size;
+                        indels[qs].push_back(indel);
+                        if (item.first == '-') {
+                            rs += size;
+                        } else {
+                            qs += size;
+                        }
+                    }
+                        break;
+                    case '*': {
+                        int is=std::max<int>(0,qs-2);
+                        int ie=std::min<int>(qv.size(),qs+3);
+                        double sum=0;
+                        int total=0;
+                        for (int i = is; i < ie; i++) { sum += qv[i];total++;}
+                        sbs_t m;
+                        m.pos=rs % wt_size;
+                        m.value = que[qs];
+                        m.qv = qv[qs];
+                        m.mean_qv = sum / total;
+                        sbs[qs].push_back(m);
+                        size = item.second.size() / 2;
+                        rs += size;
+                        qs += size;
+                    }
+                        break;
+                    default:
+                        error = std::string("Unknown state: ") + item.first;
+                }
+
+            }
+
+            double score = ( static_cast<double>(r->blen+ r->mlen)/length + r->mapq/60.0)/3.0;
+            if(mut.score < score) {
+
+                auto rng = get_trimmed_range(qv,options.trimming_window_mean,options.trimming_threshold);
 
+                for (auto &item : sbs)
+                    for (auto &v : item.second) {
+                        if (item.first < rng.first || item.first > rng.second) { v.is_trimmed = true; }
+                    }
+                for (auto &item : indels)
+                    for (auto &v : item.second) {
+                        if (item.first < rng.first || item.first > rng.second) { v.is_trimmed = true; }
+                    }
+
+                mut.name = read.name;
+                mut.comment = read.comment;
+                mut.rs = r->rs;
+                mut.re = r->re;
+                mut.qs = r->rev ? length - r->qe : r->qs;
+                mut.qe = r->rev ? length - r->qs : r->qe;
+                mut.ts = rng.first;
+                mut.te = rng.second;
+                mut.seq_len = length;
+                mut.mapq = r->mapq;
+                mut.indels = indels;
+                mut.sbs = sbs;
+                mut.blen = r->blen;
+                mut.mlen = r->mlen;
+                mut.score = score;
+                mut.variants = find_variants(que.substr(mut.qs,mut.qe-mut.qs));
+                mut.seq = que;
+                mut.qv = qv_str;
+                mut.seq_trimmed=trimm_string(que,rng.first,rng.second,'N');
+                mut.qv_trimmed=trimm_string(qv_str,rng.first,rng.second,'!');
+                mut.cs_str = cs_str;
+                mut.reverse = r->rev;
+            }
+
+            free(cs_str);
+            free(r->p);
+        }
+
+        free(reg);
+        return mut.score > 0;
+    }
+
+    //Maps the reads of the query file on threads workers and passes the mapped ones to write in input order,
+    //the reader stays at most 64 reads per thread ahead of the last one written (see cmri::orderedPipeline).
+    template<class W>
+    int mapReads(kseq_t *ks, const mm_idx_t *mi, const mm_mapopt_t &mopt, const std::vector<char> &wt_motif,
+                 const cmri::telomere_mutations_options_t &options, int threads, W write) {
+
+        auto next = [&](query_read_t &read) {
+            if (kseq_read(ks) < 0) { return false; }
+            read.name = ks->name.l > 0 ? ks->name.s : "";
+            read.comment = ks->comment.l > 0 ? ks->comment.s : "";
+            read.sequence.assign(ks->seq.s, ks->seq.l);
+            read.quality.assign(ks->qual.s, ks->qual.l);
+            return true;
+        };
+
+        std::vector<mm_tbuf_t *> tbufs;
+        for (int t = 0; t < std::max(threads, 1); t++) { tbufs.push_back(mm_tbuf_init()); }
+
+        auto map = [&](int worker, const query_read_t &read, mapped_read_t &result) {
+            return mapRead(mi, mopt, tbufs[worker], read, wt_motif, options, result.mutations, result.error) ||
+                   !result.error.empty();
+        };
+
+        //find_mutations logs, so it runs here on the calling thread.
+        auto write_mapped = [&](mapped_read_t &result) {
+            if (!result.error.empty()) {
+                cmri::LOGGER.error << result.error << std::endl;
+                exit(-1);
+            }
+            result.mutations.find_mutations(wt_motif);
+            write(result.mutations);
+        };
+
+        const uint64_t count = cmri::orderedPipeline<query_read_t, mapped_read_t>(
+                threads, 64 * static_cast<uint64_t>(std::max(threads, 1)), next, map, write_mapped);
+
+        for (auto tbuf : tbufs) { mm_tbuf_destroy(tbuf); }
+        return static_cast<int>(count);
+    }
+
+}
 
 
 int
@@ -34,12 +240,19 @@ cmri::mainTelomereMutations(common_options_t common_options, telomere_mutations_
     assert(f);
     kseq_t *ks = kseq_init(f);
 
-    std::vector<mutations_t> mutations;
     std::vector<char> wt_motif;
     for(auto c : telomere_mutation_options.wt_motif){
         wt_motif.push_back(c);
     }
-    int wt_size = wt_motif.size();
+
+    //one record per line, written as soon as the read is mapped.
+    cmri::jsonWriter output(common_options.output_path + "/output.ndjson",
+                            common_options.gzip_output ? compression_t::bgzf : compression_t::none);
+    int records = 0;
+    auto write = [&](const mutations_t &mut) {
+        output.writeLine(mut);
+        records++;
+    };
 
     // open index reader
     mm_idx_reader_t *index_reader = mm_idx_reader_open(telomere_mutation_options.target_file.c_str(), &iopt, 0);
@@ -47,196 +260,17 @@ cmri::mainTelomereMutations(common_options_t common_options, telomere_mutations_
     while ((mi = mm_idx_reader_read(index_reader, n_threads)) != 0) { // traverse each part of the index
         mm_mapopt_update(&mopt,
                          mi); // this sets the maximum minimizer occurrence; TODO: set a better default in mm_mapopt_init()!
-        mm_tbuf_t *tbuf = mm_tbuf_init(); // thread buffer; for multi-threading, allocate one tbuf for each thread
         gzrewind(f);
         kseq_rewind(ks);
-        int count=0;
-        while (kseq_read(ks) >= 0) { // each kseq_read() call reads one query sequence
-            count++;
-            mm_reg1_t *reg;
-            int j, i, n_reg;
-            reg = mm_map(mi, ks->seq.l, ks->seq.s, &n_reg, tbuf, &mopt, 0); // get all hits for the query
-
-            mutations_t mut;
-            mut.score=0;
-
-            for (j = 0; j < n_reg; ++j) { // traverse hits and print them out
-                mm_reg1_t *r = &reg[j];
-                assert(r->p); // with MM_F_CIGAR, this should not be NULL
-
-                LOGGER.debug << ks->name.s << "\tlen:"
-                            << ks->seq.l << "\tqs:"
-                            << r->qs << "\tqe:"
-                            << r->qe << "\t"
-                            << "+-"[r->rev] << std::endl;
-
-                LOGGER.debug << mi->seq[r->rid].name << "\tlen:"
-                            << mi->seq[r->rid].len << "\trs:"
-                            << r->rs << "\tre:"
-                            << r->re << "\tmlen:"
-                            << r->mlen << "\tblen:"
-                            << r->blen << "\tmapq:"
-                            << r->mapq << "\t cg:";
-                for (i = 0; i <
-                            r->p->n_cigar; ++i) {// IMPORTANT: this gives the CIGAR in the aligned regions. NO soft/hard clippings!
-                    LOGGER.debug << (r->p->cigar[i] >> 4) << "MIDNSH"[r->p->cigar[i] & 0xf];
-                }
-                LOGGER.debug << std::endl;
-
-                void *km = nullptr;
-                char *cs_str = NULL;
-                int max_len = 0;
-                int n_cs = mm_gen_cs(km, &cs_str, &max_len, mi, r, ks->seq.s, true);
-
-                LOGGER.debug << ks->seq.s << std::endl;
-                LOGGER.debug << ks->qual.s << std::endl;
-                LOGGER.debug << cs_str << std::endl;
-
-
-                auto cm_tag = parseTag(cs_str,r->rev);
-                std::map<int, std::vector<sbs_t>> sbs;
-                std::map<int, std::vector<indel_t>> indels;
-
-                int rs = r->rs;
-                int re = r->re;
-                int qs = r->qs;
-                int qe = r->qe;
-                std::string que;
-                std::string qv_str;
-                std::vector<int> qv;
-                if(r->rev){
-                    qs = ks->seq.l - r->qe;
-                    qe = ks->seq.l - r->qs;
-                    for (int i = ks->qual.l-1; i >= 0 ; i--) {
-                        qv.push_back(static_cast<int>(ks->qual.s[i]) - 33);
-                    }
-                    que=reverse_complement(ks->seq.s);
-                    qv_str = reverse_string(ks->qual.s);
-                }
-                else{
-                    for (int i = 0; i < ks->qual.l; i++) {
-                        qv.push_back(static_cast<int>(ks->qual.s[i]) - 33);
-                    }
-                    que = ks->seq.s;
-                    qv_str = ks->qual.s;
-                }
-
-
-                int size;
-                for (auto &item : cm_tag) {
-                    switch (item.first) {
-                        case ':':
-                            size = std::stoi(item.second);
-                            LOGGER.debug << "MATCH: " << que.substr(qs, size) << std::endl;
-                            rs += size;
-                            qs += size;
-                            break;
-                        case '-':
-                        case '+': {
-                            size = item.second.size();
-                            double sum = 0;
-                            for (int i = qs; i < qs + size; i++) { sum += qv[i]; }
-                            std::string kind = item.first == '-' ? "del" : "ins";
-                            LOGGER.debug << kind << " " << item.second << std::endl;
-                            indel_t indel;
-                            indel.kind = kind;
-                            indel.pos = rs%wt_size;
-                            indel.seq = item.second;
-                            indel.mean_qv = sum/size;
-                            indels[qs].push_back(indel);
-                            if (item.first == '-') {
-                                rs += size;
-                            } else {
-                                qs += size;
-                            }
-                        }
-                            break;
-                        case '*': {
-                            LOGGER.debug << "SBS: " << item.second << " " << que[qs] << std::endl;
-                            int is=std::max<int>(0,qs-2);
-                            int ie=std::min<int>(qv.size(),qs+3);
-                            double sum=0;
-                            int total=0;
-                            for (int i = is; i < ie; i++) { sum += qv[i];total++;}
-                            sbs_t m;
-                            m.pos=rs % wt_size;
-                            m.value = que[qs];
-                            m.qv = qv[qs];
-                            m.mean_qv = sum / total;
-                            sbs[qs].push_back(m);
-                            size = item.second.size() / 2;
-                            rs += size;
-                            qs += size;
-                        }
-                            break;
-                        default:
-                            LOGGER.error << "Unknown state: " << item.first;
-                            exit(-1);
-                    }
-
-                }
-
-                double score = ( static_cast<double>(r->blen+ r->mlen)/ks->seq.l + r->mapq/60.0)/3.0;
-                if(mut.score < score) {
-
-                    auto rng = get_trimmed_range(qv,telomere_mutation_options.trimming_window_mean,telomere_mutation_options.trimming_threshold);
-
-                    for (auto &item : sbs)
-                        for (auto &v : item.second) {
-                            if (item.first < rng.first || item.first > rng.second) { v.is_trimmed = true; }
-                        }
-                    for (auto &item : indels)
-                        for (auto &v : item.second) {
-                            if (item.first < rng.first || item.first > rng.second) { v.is_trimmed = true; }
-                        }
-
-                    mut.name = ks->name.l>0?ks->name.s:"";
-                    mut.comment = ks->comment.l >0 ? ks->comment.s : "";
-                    mut.rs = r->rs;
-                    mut.re = r->re;
-                    mut.qs = r->rev ? ks->seq.l - r->qe : r->qs;
-                    mut.qe = r->rev ? ks->seq.l - r->qs : r->qe;
-                    mut.ts = rng.first;
-                    mut.te = rng.second;
-                    mut.seq_len = ks->seq.l;
-                    mut.mapq = r->mapq;
-                    mut.indels = indels;
-                    mut.sbs = sbs;
-                    mut.blen = r->blen;
-                    mut.mlen = r->mlen;
-                    mut.score = score;
-                    mut.variants = find_variants(que.substr(mut.qs,mut.qe-mut.qs));
-                    mut.seq = que;
-                    mut.qv = qv_str;
-                    mut.seq_trimmed=trimm_string(que,rng.first,rng.second,'N');
-                    mut.qv_trimmed=trimm_string(qv_str,rng.first,rng.second,'!');
-                    mut.cs_str = cs_str;
-                    mut.reverse = r->rev;
-                }
-
-                free(cs_str);
-                free(r->p);
-            }
-
-            if(mut.score > 0) {
-                mut.find_mutations(wt_motif);
-                mutations.push_back(mut);
-
-            }
-
-            free(reg);
-        }
+        int count = mapReads(ks, mi, mopt, wt_motif, telomere_mutation_options, common_options.threads, write);
 
         LOGGER.info << "Total number of sequences: " << count << std::endl;
 
-        mm_tbuf_destroy(tbuf);
         mm_idx_destroy(mi);
     }
 
-
-    std::ofstream file(common_options.output_path + "/output.json");
-    file << cmri::serialize(mutations);
-    file.close();
+    output.close();
+    LOGGER.info << "Mapped sequences written: " << records << std::endl;
 
     mm_idx_reader_close(index_reader); // close the index reader
     kseq_destroy(ks); // close the query file
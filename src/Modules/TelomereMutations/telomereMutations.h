@@ -19,8 +19,7 @@ namespace cmri {
         double mean_qv;
         bool is_trimmed = false;
 
-        std::string serialize() const {
-            std::stringstream result;
+        void serialize(std::ostream &result) const {
             result << "{";
             result << "\"pos\":" << pos << ",";
             result << "\"qv\":" << qv << ",";
@@ -28,12 +27,17 @@ namespace cmri {
             result << "\"is_trimmed\":" << is_trimmed << ",";
             result << "\"value\":\"" << value << "\"";
             result << "}";
+        };
+
+        std::string serialize() const {
+            std::stringstream result;
+            serialize(result);
             return result.str();
         };
     };
 
     inline std::ostream &operator<<(std::ostream &result, const sbs_t &rhs) {
-        result << rhs.serialize();
+        rhs.serialize(result);
         return result;
     }
 
@@ -44,8 +48,7 @@ namespace cmri {
         double mean_qv;
         bool is_trimmed = false;
 
-        std::string serialize() const {
-            std::stringstream result;
+        void serialize(std::ostream &result) const {
             result << "{";
             result << "\"pos\":" << pos << ",";
             result << "\"mean_qv\":" << mean_qv << ",";
@@ -53,13 +56,18 @@ namespace cmri {
             result << "\"seq\":\"" << seq << "\",";
             result << "\"kind\":\"" << kind << "\"";
             result << "}";
+        };
+
+        std::string serialize() const {
+            std::stringstream result;
+            serialize(result);
             return result.str();
         };
 
     };
 
     inline std::ostream &operator<<(std::ostream &result, const indel_t &rhs) {
-        result << rhs.serialize();
+        rhs.serialize(result);
         return result;
     }
 
@@ -103,8 +111,7 @@ namespace cmri {
         std::string cs_str;
 
 
-        std::string serialize() const {
-            std::stringstream result;
+        void serialize(std::ostream &result) const {
             result << "{";
             result << "\"rs\":" << rs << ",";
             result << "\"re\":" << re << ",";
@@ -120,8 +127,12 @@ namespace cmri {
             result << "\"score\":" << score << ",";
             result << "\"reverse\":" << reverse << ",";
 
-            result << "\"mutations\":" << ::cmri::serialize(count) << ",";
-            result << "\"variants\":" << ::cmri::serialize(variants) << ",";
+            result << "\"mutations\":";
+            ::cmri::serialize(result, count);
+            result << ",";
+            result << "\"variants\":";
+            ::cmri::serialize(result, variants);
+            result << ",";
 
             result << "\"mean_ins_size\":" << mean_ins_size << ",";
             result << "\"mean_ins_qv\":" << mean_ins_qv << ",";
@@ -131,17 +142,28 @@ namespace cmri {
             result << "\"mean_del_qv\":" << mean_del_qv << ",";
             result << "\"del_count\":" << del_count << ",";
 
-            result << "\"sbs\":" << ::cmri::serialize(sbs) << ",";
-            result << "\"indels\":" << ::cmri::serialize(indels) << ",";
+            result << "\"sbs\":";
+            ::cmri::serialize(result, sbs);
+            result << ",";
+            result << "\"indels\":";
+            ::cmri::serialize(result, indels);
+            result << ",";
 
             result << "\"seq\":\"" << seq << "\",";
-            result << "\"qv\":\"" << escape_json(qv) << "\",";
+            result << "\"qv\":\"";
+            escape_json(result, qv);
+            result << "\",";
             //result << "\"seq_trimmed\":\"" << seq_trimmed << "\",";
             //result << "\"qv_trimmed\":\"" << escape_json(qv_trimmed) << "\",";
             result << "\"cs_str\":\"" << cs_str << "\",";
             result << "\"comment\":\"" << comment << "\",";
             result << "\"name\":\"" << name << "\"";
             result << "}";
+        };
+
+        std::string serialize() const {
+            std::stringstream result;
+            serialize(result);
             return result.str();
         };
 
@@ -213,7 +235,7 @@ namespace cmri {
     };
 
     inline std::ostream &operator<<(std::ostream &result, const mutations_t &rhs) {
-        result << rhs.serialize();
+        rhs.serialize(result);
         return result;
     }
 
@@ -8,6 +8,7 @@
 #include <sequenceReader.h>
 #include "kseq.h"
 #include "variantCallRecord.h"
+#include "jsonWriter.h"
 
 
 std::string
@@ -325,9 +326,12 @@ void cmri::mainVariantCallAnalysis(common_options_t common_options,
     bcf_hdr_destroy(vcf_header);
     vcf_close(vcf_file);
 
-    std::ofstream file(common_options.output_path + "/output.json");
-    file << cmri::serialize(regions);
-    file.close();
+    cmri::jsonWriter output(common_options.output_path + "/output.json", common_options.gzip_output);
+    output.write(regions);
+    output.close();
+    if (common_options.partial) {
+        cmri::writePartial(common_options.output_path + "/output.partial", partial_t::variant, regions);
+    }
 
 
 }
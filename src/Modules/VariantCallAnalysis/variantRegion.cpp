@@ -4,21 +4,17 @@
 
 #include "variantRegion.h"
 
-std::string cmri::variantRegion::serialize() const {
+void cmri::variantRegion::serialize(std::ostream &result) const {
 
-    std::stringstream result;
     result << "{";
     result << "\"start\":" << start;
     result << ",\"end\":" << end;
     result << ",\"name\":\"" << name << "\"";
     result << ",\"total_bases\":" << total_bases;
-    result << ",\"mutations\":" << cmri::serialize(mutations);
+    result << ",\"mutations\":";
+    cmri::serialize(result, mutations);
 
     result << "}";
-
-    return result.str();
-
-    return genomeRegion::serialize();
 }
 
 void cmri::variantRegion::deserialize(const boost::property_tree::ptree &tree) {
@@ -34,3 +30,17 @@ void cmri::variantRegion::deserialize(const boost::property_tree::ptree &tree) {
         LOGGER.error << "Exception parsing json file: " << e.what() << std::endl;
         exit(EIO);
     }}
+
+
+void cmri::variantRegion::writePartial(std::ostream &out) const {
+    writeBinary(out, start);
+    writeBinary(out, end);
+    writeBinary(out, name);
+    writeBinary(out, total_bases);
+    writeBinary(out, mutations);
+}
+
+bool cmri::variantRegion::readPartial(std::istream &in) {
+    return readBinary(in, start) && readBinary(in, end) && readBinary(in, name) && readBinary(in, total_bases) &&
+           readBinary(in, mutations);
+}
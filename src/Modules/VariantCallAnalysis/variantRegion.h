@@ -29,6 +29,7 @@
 #include <boost/lexical_cast.hpp>
 #include <genomeRegion.h>
 #include "logger.h"
+#include "partialResult.h"
 #include <map>
 #include <string>
 #include <vector>
@@ -41,9 +42,15 @@ namespace cmri{
         std::map<std::string,std::map<std::string,unsigned int>> mutations;
 
 
-        std::string serialize() const override;
+        using genomeRegion::serialize;
+        void serialize(std::ostream &result) const override;
         void deserialize(const boost::property_tree::ptree &tree) override;
 
+        //region and counts in binary form (partial results, see the Merge task).
+        void writePartial(std::ostream &out) const;
+
+        bool readPartial(std::istream &in);
+
         inline void resetCount(){
             total_bases=0;
         }
@@ -54,9 +61,14 @@ namespace cmri{
         }
 
 
-        void operator+=(variantRegion &rhs)  {
+        void operator+=(const variantRegion &rhs)  {
             if(genomeRegion::operator==(rhs)){
                 total_bases+= rhs.total_bases;
+                for(auto &mutation : rhs.mutations){
+                    for(auto &sample : mutation.second){
+                        mutations[mutation.first][sample.first] += sample.second;
+                    }
+                }
             }
             else{
                 throw std::runtime_error("error regions are not match ");
@@ -71,7 +83,7 @@ namespace cmri{
 
     inline std::ostream& operator<<(std::ostream& result, const variantRegion& rhs)
     {
-        result << rhs.serialize();
+        rhs.serialize(result);
         return result;
     }
 
@@ -3,30 +3,100 @@
 //
 
 #include "bedWriter.h"
+#include "logger.h"
+#include <algorithm>
+#include <tbx.h>
 
 /**
  *
- * @param file_name
+ * @param _file_name
+ * @param bgzf write block compressed (.gz added to the name) and build the tabix index
+ * @param _item_rgb write the itemRgb column
  */
-cmri::bedWriter::bedWriter(std::string file_name) {
+cmri::bedWriter::bedWriter(const std::string &_file_name, bool bgzf, bool _item_rgb) :
+        file_name(bgzf ? _file_name + ".gz" : _file_name), item_rgb(_item_rgb) {
 
-    file.open(file_name);
+    if (bgzf) {
+        bgzf_file = bgzf_open(file_name.c_str(), "w");
+        if (bgzf_file == nullptr) {
+            LOGGER.error << "Unable to write output file: " << file_name << std::endl;
+            exit(EIO);
+        }
+    } else {
+        boost::iostreams::file_sink file(file_name, std::ios_base::out | std::ios_base::binary);
+        if (!file.is_open()) {
+            LOGGER.error << "Unable to write output file: " << file_name << std::endl;
+            exit(EIO);
+        }
+        stream.push(file, buffer_size);
+    }
 
-    file << "#chrom"
-         << "\tchromStart"
-         << "\tchromEnd"
-         << "\tname"
-         << "\tscore"
-         << "\tstrand"
-         << "\tthickStart"
-         << "\tthickEnd"
-         << "\titemRgb"
-         << std::endl;
+    write(std::string("#chrom")
+          + "\tchromStart"
+          + "\tchromEnd"
+          + "\tname"
+          + "\tscore"
+          + "\tstrand"
+          + "\tthickStart"
+          + "\tthickEnd"
+          + (item_rgb ? "\titemRgb" : "")
+          + "\n");
+
+    if (bgzf) {
+        //tabix defaults: 16kb bins, 5 levels.
+        index = hts_idx_init(0, HTS_FMT_TBI, bgzf_tell(bgzf_file), 14, 5);
+        if (index == nullptr) {
+            LOGGER.error << "Unable to create index for: " << file_name << std::endl;
+            exit(ENOMEM);
+        }
+    }
 
 }
 
 cmri::bedWriter::~bedWriter() {
-    file.close();
+    close();
+}
+
+void cmri::bedWriter::write(const std::string &text) {
+    if (bgzf_file != nullptr) {
+        if (bgzf_write(bgzf_file, text.data(), text.size()) < 0) {
+            LOGGER.error << "Unable to write output file: " << file_name << std::endl;
+            exit(EIO);
+        }
+    } else {
+        stream << text;
+    }
+}
+
+//tabix needs the records of a chromosome together and sorted by start.
+void cmri::bedWriter::flushChromosome() {
+    if (pending.empty()) { return; }
+
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const bed_line_t &lhs, const bed_line_t &rhs) { return lhs.start < rhs.start; });
+
+    int tid = 0;
+    auto contig = contig_ids.find(current_chromosome);
+    if (contig == contig_ids.end()) {
+        tid = contigs.size();
+        contig_ids[current_chromosome] = tid;
+        contigs.push_back(current_chromosome);
+    } else {
+        tid = contig->second;
+    }
+
+    for (auto &item : pending) {
+        write(item.line);
+        //the index takes the offset at the end of the record.
+        if (index != nullptr &&
+            hts_idx_push(index, tid, std::max(item.start, 0), item.end, bgzf_tell(bgzf_file), 1) < 0) {
+            LOGGER.warning << "Records of " << current_chromosome << " are not contiguous, " << file_name
+                           << " will not be indexed." << std::endl;
+            hts_idx_destroy(index);
+            index = nullptr;
+        }
+    }
+    pending.clear();
 }
 
 /**
@@ -43,18 +113,66 @@ cmri::bedWriter::~bedWriter() {
  * @param g
  * @param b
  */
-void cmri::bedWriter::append(std::string chromosome, int start, int end, std::string name, int score, bool strand, int thickStart,
-                             int thickEnd, int r, int g,int b) {
-
-    file << chromosome
-         << "\t" << start
-         << "\t" << end
-         << "\t" << name
-         << "\t" << score
-         << "\t" << (strand ? "+" : "-")
-         << "\t" << (thickStart > 0 ? thickStart : start)
-         << "\t" << (thickEnd > 0 ? thickEnd : end)
-         << "\t" << r << "," << g << "," << b
-         << std::endl;
+void cmri::bedWriter::append(const std::string &chromosome, int start, int end, const std::string &name, int score,
+                             bool strand, int thickStart, int thickEnd, int r, int g, int b) {
+
+    line.clear();
+    line += chromosome;
+    line += "\t" + std::to_string(start);
+    line += "\t" + std::to_string(end);
+    line += "\t" + name;
+    line += "\t" + std::to_string(score);
+    line += strand ? "\t+" : "\t-";
+    line += "\t" + std::to_string(thickStart > 0 ? thickStart : start);
+    line += "\t" + std::to_string(thickEnd > 0 ? thickEnd : end);
+    if (item_rgb) { line += "\t" + std::to_string(r) + "," + std::to_string(g) + "," + std::to_string(b); }
+    line += "\n";
+
+    if (bgzf_file == nullptr) {
+        write(line);
+        return;
+    }
+
+    if (chromosome != current_chromosome) {
+        flushChromosome();
+        current_chromosome = chromosome;
+    }
+    pending.push_back({start, end, line});
+
+}
+
+bool cmri::bedWriter::close() {
+    bool good = true;
+
+    if (bgzf_file != nullptr) {
+        flushChromosome();
+        good = bgzf_flush(bgzf_file) == 0;
+        if (index != nullptr) {
+            good = hts_idx_finish(index, bgzf_tell(bgzf_file)) == 0 && good;
+
+            //tabix meta data: bed column layout followed by the chromosome names (null terminated).
+            std::string names;
+            for (auto &contig : contigs) { names.append(contig.c_str(), contig.size() + 1); }
+            int32_t layout[7] = {tbx_conf_bed.preset, tbx_conf_bed.sc, tbx_conf_bed.bc, tbx_conf_bed.ec,
+                                 tbx_conf_bed.meta_char, tbx_conf_bed.line_skip, static_cast<int32_t>(names.size())};
+            std::string meta(reinterpret_cast<const char *>(layout), sizeof(layout));
+            meta += names;
+            good = hts_idx_set_meta(index, meta.size(), reinterpret_cast<uint8_t *>(&meta[0]), 1) == 0 && good;
+        }
+        good = bgzf_close(bgzf_file) == 0 && good;
+        bgzf_file = nullptr;
+        if (index != nullptr) {
+            good = hts_idx_save_as(index, file_name.c_str(), nullptr, HTS_FMT_TBI) == 0 && good;
+            hts_idx_destroy(index);
+            index = nullptr;
+        }
+    } else {
+        if (stream.empty()) { return true; }
+        stream.flush();
+        good = stream.good();
+        stream.reset();
+    }
 
+    if (!good) { LOGGER.error << "Unable to write output file: " << file_name << std::endl; }
+    return good;
 }
@@ -32,6 +32,7 @@
 #include "options.h"
 #include "Modules/IwgsAnalysis/iwgsAnalysis.h"
 #include "Modules/TelomereMutations/telomereMutations.h"
+#include "Modules/Merge/merge.h"
 
 
 int main(const int ac, char *av[]) {
@@ -52,8 +53,9 @@ int main(const int ac, char *av[]) {
         genericOptions.add_options()
                 ("debug,d", "Shows debug messages in log")
                 ("help,h", "Shows a help message")
-                ("task", boost::program_options::value<std::string>(&task), "Perform one of the following tasks: [MotifCount, GenomeAnalysis, VariantCallAnalysis, IwgsAnalysis, TelomereMutations]")
+                ("task", boost::program_options::value<std::string>(&task), "Perform one of the following tasks: [MotifCount, GenomeAnalysis, VariantCallAnalysis, IwgsAnalysis, TelomereMutations, Merge]")
                 ("parameters,p", boost::program_options::value<std::string>(&parameters), "Parameters file")
+                ("resume", "Continue an interrupted run from the checkpoint in the output directory")
                 ("silent,s", "Shows only errors");
 
 
@@ -64,7 +66,11 @@ int main(const int ac, char *av[]) {
                 ("common.chunk_size", boost::program_options::value<int>(&common.chunk_size)->default_value(10000), "Size of the reading chuck")
                 ("common.input_file,i", boost::program_options::value<std::string>(&common.input_file), "Input file")
                 ("common.output_path,o", boost::program_options::value<std::string>(&common.output_path)->default_value("output"), "Output directory name")
+                ("common.gzip_output", boost::program_options::value<bool>(&common.gzip_output)->default_value(false), "Write the json results gzip compressed (output.json.gz, TelomereMutations: bgzip output.ndjson.gz, GenomeAnalysis: bgzip and tabix indexed bed files)")
+                ("common.partial", boost::program_options::value<bool>(&common.partial)->default_value(false), "Also write the results as a binary partial (output.partial) for the Merge task")
                 ("common.progress", boost::program_options::value<int>(&common.progress)->default_value(0), "Show progress message every X records (0 - off)")
+                ("common.shard_count", boost::program_options::value<int>(&common.shard_count)->default_value(1), "Split the input file in X shards read by independent runs (fasta, fastq, bgzip or bam input)")
+                ("common.shard_index", boost::program_options::value<int>(&common.shard_index)->default_value(0), "Shard read by this run, from 0 to shard_count - 1")
                 ("common.threads", boost::program_options::value<int>(&common.threads)->default_value(1), "Number of threads")
                 ;
 
@@ -75,6 +81,12 @@ int main(const int ac, char *av[]) {
                 ("motif_count.quality_value", boost::program_options::value<int>(&motif_count.quality_value)->default_value(0), "Mean base quality threshold")
                 ("motif_count.quality_map", boost::program_options::value<int>(&motif_count.quality_map)->default_value(0), "Quality Mapping threshold")
                 ("motif_count.validate", boost::program_options::value<bool>(&motif_count.validate_sequence)->default_value(false), "Validate sequences (slow)")
+                ("motif_count.quality_histogram", boost::program_options::value<bool>(&motif_count.quality_histogram)->default_value(true), "Histogram of hits by mean base quality (0 - every hit in bin 0, skips quality decoding)")
+                ("motif_count.indexed", boost::program_options::value<bool>(&motif_count.indexed)->default_value(false), "Read only the regions in the motif file (requires bam index)")
+                ("motif_count.unmapped", boost::program_options::value<bool>(&motif_count.unmapped)->default_value(true), "Include unmapped reads when reading indexed regions")
+                ("motif_count.partition", boost::program_options::value<std::string>(&motif_count.partition)->default_value("none"), "Split an indexed bam by contig or tile, one reader per thread (none, contig, tile)")
+                ("motif_count.tile_size", boost::program_options::value<int>(&motif_count.tile_size)->default_value(10000000), "Tile size (bp) for motif_count.partition=tile")
+                ("motif_count.checkpoint", boost::program_options::value<int>(&motif_count.checkpoint)->default_value(0), "Save partial counts every X reads, continue with --resume (0 - off)")
         ;
 
         cmri::variant_call_analysis_options_t variant_call_analysis;
@@ -112,6 +124,12 @@ int main(const int ac, char *av[]) {
                 ;
 
 
+        cmri::merge_options_t merge;
+        boost::program_options::options_description mergeOptions("Merge Options");
+        mergeOptions.add_options()
+                ("merge.partials", boost::program_options::value<std::vector<std::string>>(&merge.partials)->multitoken(), "Partial results (output.partial) of runs of the same task")
+                ;
+
 
         boost::program_options::positional_options_description positional;
         positional.add("task", 1);
@@ -124,6 +142,7 @@ int main(const int ac, char *av[]) {
         .add(genomeAnalysisOptions)
         .add(iwgsAnalysisOptions)
         .add(telomereMutationsOptions)
+        .add(mergeOptions)
                 ;
 
         boost::program_options::options_description configFileOptions;
@@ -133,6 +152,7 @@ int main(const int ac, char *av[]) {
         .add(genomeAnalysisOptions)
         .add(iwgsAnalysisOptions)
         .add(telomereMutationsOptions)
+        .add(mergeOptions)
                 ;
 
         boost::program_options::variables_map vm;
@@ -154,7 +174,8 @@ int main(const int ac, char *av[]) {
         }
 
 
-        cmri::create_output_directory(common.output_path, common.backup);
+        common.resume = vm.count("resume");
+        cmri::create_output_directory(common.output_path, common.backup, common.resume);
         cmri::log_command(common.output_path, ac, av);
         std::string log_file = common.output_path + "/output.log";
 
@@ -173,6 +194,12 @@ int main(const int ac, char *av[]) {
 
         cmri::show_options(vm);
 
+        //only MotifCount reads shards (see sequenceReader::setShard), other tasks would process the whole input.
+        if (common.shard_count > 1 && cmri::str2task.at(task) != cmri::task_t::MotifCount) {
+            cmri::LOGGER.error << "Invalid argument. common.shard_count is only supported by MotifCount." << std::endl;
+            exit(EINVAL);
+        }
+
         switch (cmri::str2task.at(task)) {
 
             case cmri::task_t::GenomeAnalysis :
@@ -188,6 +215,8 @@ int main(const int ac, char *av[]) {
             case cmri::task_t::MotifCount :
                 motif_count.validate();
                 common.validate();
+                //the shards are combined by the Merge task.
+                if (common.shard_count > 1) { common.partial = true; }
                 cmri::mainMotifCount(common,motif_count);
                 break;
             case cmri::task_t::QVSelector :
@@ -208,6 +237,10 @@ int main(const int ac, char *av[]) {
                 common.validate();
                 cmri::mainVariantCallAnalysis(common, variant_call_analysis);
                 break;
+            case cmri::task_t::Merge :
+                merge.validate();
+                cmri::mainMerge(common, merge);
+                break;
             default:
                 cmri::LOGGER.error << "Unknown task: " << task << std::endl;
                 cmri::LOGGER.error << "Valid options are: " << std::endl;
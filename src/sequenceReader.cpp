@@ -1,5 +1,9 @@
 #include <utils.h>
 #include <csvParser.h>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <unistd.h>
 #include "sequenceReader.h"
 
 //
@@ -26,11 +30,217 @@
 //
 
 
-cmri::sequenceReader::sequenceReader(std::string input_file, int _quality_value, int _quality_map) :
-        quality_value(_quality_value), quality_map(_quality_map) {
+namespace {
+
+    //IUPAC characters of both bases packed in a bam sequence byte.
+    struct nt16_pair_table_t {
+        char pair[256][2];
+
+        nt16_pair_table_t() {
+            for (int i = 0; i < 256; i++) {
+                pair[i][0] = seq_nt16_str[i >> 4];
+                pair[i][1] = seq_nt16_str[i & 0xf];
+            }
+        }
+    };
+
+    const nt16_pair_table_t nt16_pair_table;
+
+    const int64_t bgzf_max_block = 65536;
+    const int bgzf_header_size = 18;
+
+    inline uint32_t uint32At(const uint8_t *p) {
+        return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    //gzip header with the BC extra field that starts every bgzf block (as checked by htslib).
+    inline bool isBgzfHeader(const uint8_t *h) {
+        return h[0] == 31 && h[1] == 139 && h[2] == 8 && (h[3] & 4) && (h[10] | h[11] << 8) == 6 &&
+               h[12] == 'B' && h[13] == 'C' && (h[14] | h[15] << 8) == 2;
+    }
+
+    //compressed and inflated size of the bgzf block at position, false if no block starts there.
+    bool bgzfBlockSize(std::ifstream &file, int64_t position, int64_t &block_size, int64_t &data_size) {
+        uint8_t header[bgzf_header_size];
+        uint8_t isize[4];
+        file.clear();
+        file.seekg(position);
+        if (!file.read(reinterpret_cast<char *>(header), bgzf_header_size) || !isBgzfHeader(header)) { return false; }
+        block_size = (header[16] | header[17] << 8) + 1;
+        file.seekg(position + block_size - 4);
+        if (!file.read(reinterpret_cast<char *>(isize), 4)) { return false; }
+        data_size = uint32At(isize);
+        return true;
+    }
+
+    //raw offset of the first bgzf block starting at or after position, file_size if there is none. A header is only
+    //taken when another block (or the end of the file) follows it, compressed data rarely looks like two of them.
+    int64_t nextBgzfBlock(std::ifstream &file, int64_t position, int64_t file_size) {
+        std::vector<uint8_t> buffer;
+        while (position < file_size) {
+            const int64_t length = std::min(3 * bgzf_max_block, file_size - position);
+            buffer.resize(length);
+            file.clear();
+            file.seekg(position);
+            if (!file.read(reinterpret_cast<char *>(buffer.data()), length)) { break; }
+            for (int64_t i = 0; i < bgzf_max_block && i + bgzf_header_size <= length; i++) {
+                if (!isBgzfHeader(&buffer[i])) { continue; }
+                const int64_t next = i + (buffer[i + 16] | buffer[i + 17] << 8) + 1;
+                if (position + next == file_size ||
+                    (next + bgzf_header_size <= length && isBgzfHeader(&buffer[next]))) { return position + i; }
+            }
+            position += bgzf_max_block;
+        }
+        return file_size;
+    }
+
+    //bytes of the bgzf blocks in [begin, end) once inflated.
+    int64_t inflatedSize(std::ifstream &file, int64_t begin, int64_t end) {
+        int64_t result = 0;
+        int64_t block_size, data_size;
+        while (begin < end && bgzfBlockSize(file, begin, block_size, data_size)) {
+            result += data_size;
+            begin += block_size;
+        }
+        return result;
+    }
+
+    //true if the fixed fields and read name at data[p] can be a bam record, size is then the record size.
+    bool isBamRecord(const std::vector<uint8_t> &data, size_t p, int32_t n_targets, int64_t &size) {
+        if (p + 36 > data.size()) { return false; }
+        const uint8_t *r = &data[p];
+        const auto block_size = static_cast<int32_t>(uint32At(r));
+        const auto ref_id = static_cast<int32_t>(uint32At(r + 4));
+        const auto pos = static_cast<int32_t>(uint32At(r + 8));
+        const uint32_t name_length = r[12];
+        const uint32_t cigar_length = r[16] | r[17] << 8;
+        const auto seq_length = static_cast<int32_t>(uint32At(r + 20));
+        const auto next_ref_id = static_cast<int32_t>(uint32At(r + 24));
+        const auto next_pos = static_cast<int32_t>(uint32At(r + 28));
+        if (ref_id < -1 || ref_id >= n_targets || next_ref_id < -1 || next_ref_id >= n_targets || pos < -1 ||
+            next_pos < -1 || name_length < 1 || seq_length < 0 || block_size < 32) { return false; }
+        if (32 + name_length + 4 * static_cast<int64_t>(cigar_length) + (static_cast<int64_t>(seq_length) + 1) / 2 +
+            seq_length > block_size) { return false; }
+        if (p + 36 + name_length <= data.size()) {
+            const uint8_t *name = r + 36;
+            if (name[name_length - 1] != 0) { return false; }
+            for (uint32_t i = 0; i + 1 < name_length; i++) {
+                if (name[i] < '!' || name[i] > '~') { return false; }
+            }
+        }
+        size = 4 + static_cast<int64_t>(block_size);
+        return true;
+    }
+
+    //virtual offset of the first bam record starting at or after the virtual offset begin, in a block before the raw
+    //offset end_block; -1 if there is none. A position is taken when it and the records after it (up to chain of
+    //them, or the end of the file) are valid.
+    int64_t findBamRecord(BGZF *fp, int64_t begin, int64_t end_block, int32_t n_targets) {
+
+        struct span_t {
+            size_t start; //in data
+            int64_t address; //of the block
+            int offset; //of data[start] in the block
+        };
+        std::vector<uint8_t> data;
+        std::vector<span_t> spans;
+        bool eof = bgzf_seek(fp, begin, SEEK_SET) < 0;
+
+        //inflate blocks until data holds size bytes or the file ends. After the seek the first block is read from
+        //its offset in begin.
+        auto load = [&](size_t size) {
+            while (!eof && data.size() < size) {
+                if (bgzf_read_block(fp) < 0 || fp->block_length == 0) {
+                    eof = true;
+                    break;
+                }
+                const auto *block = static_cast<const uint8_t *>(fp->uncompressed_block);
+                spans.push_back({data.size(), fp->block_address, fp->block_offset});
+                data.insert(data.end(), block + fp->block_offset, block + fp->block_length);
+            }
+        };
+        auto spanOf = [&](size_t p) {
+            return std::prev(std::upper_bound(spans.begin(), spans.end(), p,
+                                              [](size_t q, const span_t &span) { return q < span.start; }));
+        };
+
+        const int chain = 3;
+        const int64_t check_size = 36 + 256; //fixed fields and read name
+        for (size_t p = 0;; p++) {
+            load(p + check_size);
+            if (p >= data.size()) { return -1; }
+            auto span = spanOf(p);
+            if (span->address >= end_block) { return -1; }
+
+            bool valid = true;
+            size_t q = p;
+            for (int records = 0; records < chain; records++) {
+                load(q + check_size);
+                if (q == data.size() && eof && records > 0) { break; } //the last records of the file
+                int64_t size;
+                if (!isBamRecord(data, q, n_targets, size)) {
+                    valid = false;
+                    break;
+                }
+                q += size;
+            }
+            if (valid) { return span->address << 16 | (span->offset + static_cast<int64_t>(p - span->start)); }
+        }
+    }
+
+    //uncompressed offset of the first fasta/fastq record after a line break at or after the current position of the
+    //stream, -1 if there is none or the line break is not before end. Fastq records (four lines) are told apart from
+    //quality lines starting with '@' by their '+' line.
+    int64_t findFastxRecord(gzFile file, bool fasta, int64_t end) {
+
+        std::string data;
+        bool eof = false;
+        auto load = [&](size_t size) {
+            char buffer[65536];
+            while (!eof && data.size() < size) {
+                int read = gzread(file, buffer, sizeof(buffer));
+                if (read <= 0) { eof = true; } else { data.append(buffer, read); }
+            }
+        };
+        //position of the line break ending the line at p, the end of the data for a last line without it.
+        auto lineEnd = [&](size_t p) {
+            size_t result;
+            while ((result = data.find('\n', p)) == std::string::npos && !eof) { load(data.size() + 1); }
+            return result == std::string::npos ? data.size() : result;
+        };
+
+        size_t line_break = 0;
+        while (true) {
+            line_break = lineEnd(line_break);
+            if (line_break >= data.size() || static_cast<int64_t>(line_break) >= end) { return -1; }
+            const size_t start = line_break + 1;
+            line_break = start;
+            load(start + 1);
+            if (start >= data.size()) { return -1; }
+            if (fasta) {
+                if (data[start] == '>') { return start; }
+                continue;
+            }
+            if (data[start] != '@') { continue; }
+            const size_t sequence = lineEnd(start) + 1;
+            const size_t separator = lineEnd(sequence) + 1;
+            load(separator + 1);
+            if (separator >= data.size() || data[separator] != '+') { continue; }
+            const size_t quality = lineEnd(separator) + 1;
+            if (lineEnd(quality) - quality == separator - 1 - sequence) { return start; }
+        }
+    }
+
+}
+
+
+cmri::sequenceReader::sequenceReader(std::string input_file, int _quality_value, int _quality_map, int _threads) :
+        file_name(input_file), quality_value(_quality_value), quality_map(_quality_map), threads(_threads) {
 
     count = 0;
-    total_reads= count_reads(input_file);
+    std::ifstream size_stream(input_file, std::ios_base::binary | std::ios_base::ate);
+    file_size = size_stream ? static_cast<int64_t>(size_stream.tellg()) : 0;
+    range_end = file_size;
 
     auto format_flag = cmri::file_format(input_file);
     auto format = static_cast<cmri::format_t>(format_flag & cmri::format_t::FILE_TYPE);
@@ -42,6 +252,7 @@ cmri::sequenceReader::sequenceReader(std::string input_file, int _quality_value,
             kseq = kseq_init(file);
             getItem = &sequenceReader::getFastxItem;
             closeFile = &sequenceReader::closeFastxFile;
+            fileOffset = &sequenceReader::fastxFileOffset;
         }
             break;
         case cmri::format_t::CSV: {
@@ -58,14 +269,28 @@ cmri::sequenceReader::sequenceReader(std::string input_file, int _quality_value,
 
             getItem = &sequenceReader::getCsvItem;
             closeFile = &sequenceReader::closeCsvFile;
+            fileOffset = &sequenceReader::csvFileOffset;
         }
             break;
         case cmri::format_t::BAM: {
             bam_file = hts_open(input_file.c_str(), "r");
+            if (bam_file == nullptr) {
+                cmri::LOGGER.error << "Unable to open bam file: " << input_file << std::endl;
+                exit(EIO);
+            }
+            if (threads > 1) {
+                //BGZF blocks are inflated by the pool while the caller consumes records.
+                thread_pool.pool = hts_tpool_init(threads);
+                if (thread_pool.pool == nullptr || hts_set_opt(bam_file, HTS_OPT_THREAD_POOL, &thread_pool) != 0) {
+                    cmri::LOGGER.warning << "Unable to set up decompression threads, reading bam on a single thread."
+                                         << std::endl;
+                }
+            }
             bam_header = sam_hdr_read(bam_file); //read header
             alignment = bam_init1(); //initialize an alignment
             getItem = &sequenceReader::getBamItem;
             closeFile = &sequenceReader::closeBamFile;
+            fileOffset = &sequenceReader::bamFileOffset;
         }
             break;
         case cmri::format_t::UNKNOWN:
@@ -76,21 +301,28 @@ cmri::sequenceReader::sequenceReader(std::string input_file, int _quality_value,
 
 }
 
+double cmri::sequenceReader::meanQuality(read_item_t &item) {
+    if (item.raw_quality.empty()) { return 0; }
+    if (decode_quality) {
+        item.decodeQuality();
+        return static_cast<double>(item.qsum.back()) / item.raw_quality.size();
+    }
+    if (quality_value == 0) { return 0; } //no threshold, the mean is not needed
+
+    uint64_t qv_sum = 0;
+    for (auto c : item.raw_quality) { qv_sum += static_cast<uint8_t>(c); }
+    return static_cast<double>(qv_sum) / item.raw_quality.size() - item.quality_offset;
+}
+
 bool cmri::sequenceReader::getFastxItem(read_item_t &item) {
 
     item.clear();
     int l;
     if ((l = kseq_read(kseq)) >= 0) {
-        item.sequence = kseq->seq.s;
-        double mean_qv = 0;
-        if (kseq->qual.l > 0) {
-            for (int i = 0; i < kseq->qual.l; i++) {
-                int qv= static_cast<int>(kseq->qual.s[i]) - 33;
-                item.qvalue.push_back(qv);
-                mean_qv += qv;
-            }
-            mean_qv /= kseq->qual.l;
-        }
+        item.sequence.assign(kseq->seq.s, kseq->seq.l);
+        item.raw_quality.assign(kseq->qual.s, kseq->qual.l);
+        item.quality_offset = 33;
+        double mean_qv = meanQuality(item);
         item.name = mean_qv < quality_value ? "qv_fail" : "unmapped";
         count++;
         item.valid= true;
@@ -102,12 +334,79 @@ bool cmri::sequenceReader::getFastxItem(read_item_t &item) {
 }
 
 void cmri::sequenceReader::closeFastxFile() {
+    gzFile file = kseq->f->f;
     kseq_destroy(kseq);
+    gzclose(file);
+}
+
+bool cmri::sequenceReader::getFastxShardItem(read_item_t &item) {
+    //the next record belongs to the next shard once the line break before it is past the end of this one.
+    if (tell() > shard_end) {
+        item.clear();
+        return false;
+    }
+    return getFastxItem(item);
+}
+
+void cmri::sequenceReader::setFastxShard(int index, int shard_count) {
+
+    const bool compressed = file_format(file_name) & format_t::GZIP;
+    std::ifstream raw(file_name, std::ios_base::binary);
+    int64_t block_size, data_size;
+    if (compressed && !bgzfBlockSize(raw, 0, block_size, data_size)) {
+        LOGGER.error << "Only bgzip compressed files can be split in shards: " << file_name << std::endl;
+        exit(EINVAL);
+    }
+
+    //raw range of the shard, moved to the next block start for bgzf files.
+    auto boundary = [&](int shard) {
+        if (shard >= shard_count) { return file_size; }
+        const int64_t position = file_size * shard / shard_count;
+        return compressed ? nextBgzfBlock(raw, position, file_size) : position;
+    };
+    range_begin = boundary(index);
+    range_end = boundary(index + 1);
+    if (index + 1 == shard_count) {
+        shard_end = std::numeric_limits<int64_t>::max();
+    } else {
+        shard_end = compressed ? inflatedSize(raw, range_begin, range_end) : range_end - range_begin;
+    }
+
+    //the file is opened again at the start of the range, a bgzf block is a gzip member on its own.
+    closeFastxFile();
+    int fd = open(file_name.c_str(), O_RDONLY);
+    gzFile shard_file = fd >= 0 && lseek(fd, range_begin, SEEK_SET) >= 0 ? gzdopen(fd, "r") : nullptr;
+    if (shard_file == nullptr) {
+        LOGGER.error << "Unable to read shard " << index << " of: " << file_name << std::endl;
+        exit(EIO);
+    }
+
+    int64_t start = 0;
+    if (index > 0) {
+        const bool fasta = (file_format(file_name) & format_t::FILE_TYPE) == format_t::FASTA;
+        start = findFastxRecord(shard_file, fasta, shard_end);
+        if (start < 0) {
+            start = 0;
+            shard_end = -1; //no record starts in the shard
+        }
+    }
+    if (gzseek(shard_file, start, SEEK_SET) < 0) {
+        LOGGER.error << "Unable to read shard " << index << " of: " << file_name << std::endl;
+        exit(EIO);
+    }
+    kseq = kseq_init(shard_file);
+    getItem = &sequenceReader::getFastxShardItem;
+}
+
+int64_t cmri::sequenceReader::fastxFileOffset() {
+    //raw offset for both gzip and plain files.
+    return gzoffset(kseq->f->f);
 }
 
 
 bool cmri::sequenceReader::getCsvItem(read_item_t &item) {
 
+    item.clear();
     std::string line;
     if (std::getline(*instream, line)) {
         auto field = csv_parser->parseLine(line);
@@ -125,77 +424,372 @@ void cmri::sequenceReader::closeCsvFile() {
     file.close();
 }
 
+int64_t cmri::sequenceReader::csvFileOffset() {
+    auto offset = static_cast<int64_t>(file.tellg());
+    return offset < 0 ? file_size : offset;
+}
+
 
 bool cmri::sequenceReader::getBamItem(read_item_t &item) {
 
     item.clear();
     if (sam_read1(bam_file, bam_header, alignment) > 0) {
-        int chromosome_id = alignment->core.tid;
+        decodeBamItem(item);
+        return true;
+    }
+
+    return false;
+}
+
+bool cmri::sequenceReader::getBamRegionItem(read_item_t &item) {
+
+    item.clear();
+    if (sam_itr_next(bam_file, bam_iterator, alignment) >= 0) {
+        decodeBamItem(item);
+        return true;
+    }
+
+    if (unmapped_tail) {
+        //reads without coordinates are stored at the end of the file.
+        unmapped_tail = false;
+        hts_itr_destroy(bam_iterator);
+        bam_iterator = sam_itr_queryi(bam_index, HTS_IDX_NOCOOR, 0, 0);
+        if (bam_iterator != nullptr) { return getBamRegionItem(item); }
+    }
+
+    return false;
+}
+
+bool cmri::sequenceReader::getBamPartitionItem(read_item_t &item) {
+
+    item.clear();
+    while (sam_itr_next(bam_file, bam_iterator, alignment) >= 0) {
+        //reads overlapping the start of the partition belong to the one where they start.
+        if (partition_tid >= 0 && alignment->core.pos < partition_begin) { continue; }
+        decodeBamItem(item);
+        return true;
+    }
 
-        if ((alignment->core.flag & BAM_FSECONDARY)
-            || (alignment->core.flag & BAM_FDUP)
+    return false;
+}
+
+bool cmri::sequenceReader::getBamShardItem(read_item_t &item) {
+    //the next record belongs to the next shard once it starts in a block past the end of this one.
+    if ((bgzf_tell(bam_file->fp.bgzf) >> 16) >= shard_end) {
+        item.clear();
+        return false;
+    }
+    return getBamItem(item);
+}
+
+void cmri::sequenceReader::setBamShard(int index, int shard_count) {
+
+    BGZF *fp = bam_file->fp.bgzf;
+    const int64_t data_start = bgzf_tell(fp); //first record, after the header
+    const int64_t first_block = data_start >> 16;
+
+    //raw range of the shard in the blocks after the header, moved to the next block start.
+    std::ifstream raw(file_name, std::ios_base::binary);
+    auto boundary = [&](int shard) {
+        if (shard >= shard_count) { return file_size; }
+        return nextBgzfBlock(raw, first_block + (file_size - first_block) * shard / shard_count, file_size);
+    };
+    range_begin = boundary(index);
+    range_end = boundary(index + 1);
+    shard_end = range_end;
+
+    if (index > 0) {
+        const int64_t record = range_begin < range_end ? findBamRecord(fp, std::max(range_begin << 16, data_start),
+                                                                       range_end, bam_header->n_targets) : -1;
+        if (record < 0) {
+            shard_end = 0; //no record starts in the shard
+        } else if (bgzf_seek(fp, record, SEEK_SET) < 0) {
+            LOGGER.error << "Unable to read shard " << index << " of: " << file_name << std::endl;
+            exit(EIO);
+        }
+    }
+    getItem = &sequenceReader::getBamShardItem;
+}
+
+void cmri::sequenceReader::decodeBamItem(read_item_t &item) {
+
+    int chromosome_id = alignment->core.tid;
+
+    if ((alignment->core.flag & BAM_FSECONDARY)
+        || (alignment->core.flag & BAM_FDUP)
 //            || (alignment->core.flag & BAM_FQCFAIL)
-            || (alignment->core.flag & BAM_FSUPPLEMENTARY)
-                ) {
+        || (alignment->core.flag & BAM_FSUPPLEMENTARY)
+            ) {
 #ifdef DEBUG
-            LOGGER.debug << "BAM_FSECONDARY,  BAM_FDUP, BAM_FQCFAIL, BAM_FSUPPLEMENTARY" << std::endl;
+        LOGGER.debug << "BAM_FSECONDARY,  BAM_FDUP, BAM_FQCFAIL, BAM_FSUPPLEMENTARY" << std::endl;
 #endif
-            return true;
-        }
+        return;
+    }
 
-        //contig name (chromosome)
-        std::string chromosome = chromosome_id >= 0 ? bam_header->target_name[chromosome_id] : "unmapped";
-        auto query_name = bam_get_qname(alignment);
-        auto quality = bam_get_seq(alignment); //quality string
-
-        uint32_t len = alignment->core.l_qseq; //length of the read.
-        int32_t start = alignment->core.pos + 1; //left most position of alignment in zero based coordinate (+1)
-        int32_t end = start + len;
-
-        std::string sequence = "";
-        double mean_qv = 0;
-        for (int i = 0; i < len; i++) {
-            sequence += seq_nt16_str[bam_seqi(quality, i)]; //gets nucleotide id and converts them into IUPAC id.
-            int qv = static_cast<int>(quality[i]);
-            item.qvalue.push_back(qv);
-            mean_qv += qv;
-        }
-        mean_qv /= len;
-        uint32_t mapping_quality = alignment->core.qual;
+    const uint8_t *packed = bam_get_seq(alignment); //4-bit encoded bases
+    const uint8_t *quality = bam_get_qual(alignment); //phred values
+
+    uint32_t len = alignment->core.l_qseq; //length of the read.
+    int32_t start = alignment->core.pos + 1; //left most position of alignment in zero based coordinate (+1)
+    int32_t end = start + len;
 
-        if (chromosome_id >= 0) {
-            if (mean_qv < quality_value) { chromosome = "qv_fail"; }
+    //decode straight into the item buffers, two bases per packed byte.
+    item.sequence.resize(len);
+    char *bases = &item.sequence[0];
+    for (uint32_t i = 0; i < len / 2; i++) {
+        std::memcpy(bases + 2 * i, nt16_pair_table.pair[packed[i]], 2);
+    }
+    if (len & 1) { bases[len - 1] = seq_nt16_str[packed[len / 2] >> 4]; }
+
+    item.raw_quality.assign(reinterpret_cast<const char *>(quality), len);
+    item.quality_offset = 0;
+    double mean_qv = meanQuality(item);
+    uint32_t mapping_quality = alignment->core.qual;
+
+    //contig name (chromosome)
+    if (chromosome_id >= 0) {
+        if (mean_qv < quality_value) { item.name = "qv_fail"; }
+        else {
+            if (mapping_quality < quality_map) { item.name = "mapq_fail"; }
             else {
-                if (mapping_quality < quality_map) { chromosome = "mapq_fail"; }
+                item.name = bam_header->target_name[chromosome_id];
+                item.tid = chromosome_id;
             }
         }
+    } else {
+        item.name = "unmapped";
 #ifdef DEBUG
-        else {LOGGER.debug << "unmapped " << std::endl;}
+        LOGGER.debug << "unmapped " << std::endl;
 #endif
-        item.sequence = sequence;
-        item.end = end;
-        item.name = chromosome;
-        item.start= start;
-        item.valid= true;
-        count++;
-        return true;
     }
+    item.end = end;
+    item.start= start;
+    item.valid= true;
+    count++;
+}
 
-    return false;
+std::vector<std::string> cmri::sequenceReader::getContigNames() const {
+    std::vector<std::string> result;
+    if (bam_header != nullptr) {
+        for (int tid = 0; tid < bam_header->n_targets; tid++) { result.emplace_back(bam_header->target_name[tid]); }
+    }
+    return result;
+}
+
+std::vector<int64_t> cmri::sequenceReader::getContigLengths() const {
+    std::vector<int64_t> result;
+    if (bam_header != nullptr) {
+        for (int tid = 0; tid < bam_header->n_targets; tid++) { result.push_back(bam_header->target_len[tid]); }
+    }
+    return result;
+}
+
+void cmri::sequenceReader::loadBamIndex() {
+    if (bam_index != nullptr) { return; }
+    bam_index = sam_index_load(bam_file, bam_file->fn);
+    if (bam_index == nullptr) {
+        LOGGER.error << "Expecting bam index (.bai or .csi) for: " << bam_file->fn << std::endl;
+        exit(ENOENT);
+    }
+}
+
+bool cmri::sequenceReader::setRegions(const std::vector<std::string> &regions, bool unmapped) {
+
+    if (getItem != &sequenceReader::getBamItem) {
+        LOGGER.warning << "Region queries require an indexed bam file, reading the whole input." << std::endl;
+        return false;
+    }
+
+    loadBamIndex();
+
+    //keep only regions on contigs present in the header.
+    std::vector<char *> query;
+    for (auto &region : regions) {
+        std::string contig = region.substr(0, region.rfind(':'));
+        if (sam_hdr_name2tid(bam_header, contig.c_str()) >= 0 || sam_hdr_name2tid(bam_header, region.c_str()) >= 0) {
+            query.push_back(const_cast<char *>(region.c_str()));
+        }
+    }
+
+    //the multi-region iterator merges overlapping regions, so each read is returned once.
+    if (query.empty()) {
+        bam_iterator = sam_itr_queryi(bam_index, HTS_IDX_NONE, 0, 0);
+    } else {
+        bam_iterator = sam_itr_regarray(bam_index, bam_header, query.data(), query.size());
+    }
+    if (bam_iterator == nullptr) {
+        LOGGER.error << "Unable to query regions in: " << bam_file->fn << std::endl;
+        exit(EINVAL);
+    }
+
+    LOGGER.info << "Querying " << query.size() << " of " << regions.size() << " regions"
+                << (unmapped ? " and unmapped reads." : ".") << std::endl;
+
+    unmapped_tail = unmapped;
+    getItem = &sequenceReader::getBamRegionItem;
+    return true;
+}
+
+bool cmri::sequenceReader::setPartition(int32_t tid, int64_t begin, int64_t end) {
+
+    if (bam_header == nullptr) {
+        LOGGER.warning << "Partitions require an indexed bam file." << std::endl;
+        return false;
+    }
+    loadBamIndex();
+
+    if (bam_iterator != nullptr) { hts_itr_destroy(bam_iterator); }
+    bam_iterator = tid >= 0 ? sam_itr_queryi(bam_index, tid, begin, end)
+                            : sam_itr_queryi(bam_index, HTS_IDX_NOCOOR, 0, 0);
+    if (bam_iterator == nullptr) {
+        LOGGER.error << "Unable to query partition " << tid << ":" << begin << "-" << end
+                     << " in: " << bam_file->fn << std::endl;
+        exit(EINVAL);
+    }
+
+    partition_tid = tid;
+    partition_begin = begin;
+    unmapped_tail = false;
+    getItem = &sequenceReader::getBamPartitionItem;
+    return true;
+}
+
+void cmri::sequenceReader::setShard(int index, int shard_count) {
+
+    if (shard_count <= 1) { return; }
+    if (getItem == &sequenceReader::getFastxItem) {
+        setFastxShard(index, shard_count);
+    } else if (getItem == &sequenceReader::getBamItem) {
+        setBamShard(index, shard_count);
+    } else {
+        LOGGER.error << "Shards require a fasta, fastq (plain or bgzip) or bam file: " << file_name << std::endl;
+        exit(EINVAL);
+    }
+    LOGGER.info << "Reading shard " << index << " of " << shard_count << ", bytes " << range_begin << " to "
+                << range_end << " of " << file_name << std::endl;
 }
 
 void cmri::sequenceReader::closeBamFile() {
+    if (bam_iterator != nullptr) { hts_itr_destroy(bam_iterator); }
+    if (bam_index != nullptr) { hts_idx_destroy(bam_index); }
     bam_destroy1(alignment);
     bam_hdr_destroy(bam_header);
     sam_close(bam_file);
+    //the pool must outlive the file that uses it.
+    if (thread_pool.pool != nullptr) {
+        hts_tpool_destroy(thread_pool.pool);
+        thread_pool.pool = nullptr;
+    }
+}
+
+int64_t cmri::sequenceReader::bamFileOffset() {
+    //compressed offset of the current bgzf block.
+    return bgzf_tell(bam_file->fp.bgzf) >> 16;
+}
+
+
+size_t cmri::sequenceReader::get(read_batch_t &batch) {
+
+    batch.clear();
+    while (batch.size < batch.capacity()) {
+        //skipped records leave the slot invalid, it is filled again by the next read.
+        read_item_t &item = batch.items[batch.size];
+        if (!(this->*getItem)(item)) { break; }
+        if (item.valid) { batch.size++; }
+    }
+    return batch.size;
+}
+
+
+cmri::read_batch_t *cmri::readBatchPool::acquire() {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    read_batch_t *batch;
+    if (free_batches.empty()) {
+        batches.emplace_back(new read_batch_t(batch_size));
+        batch = batches.back().get();
+    } else {
+        batch = free_batches.back();
+        free_batches.pop_back();
+    }
+    batch->clear();
+    return batch;
+}
+
+void cmri::readBatchPool::release(read_batch_t *batch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    free_batches.push_back(batch);
+}
+
+
+int64_t cmri::sequenceReader::tell() {
+    if (getItem == &sequenceReader::getFastxItem || getItem == &sequenceReader::getFastxShardItem) {
+        //bytes read from the file but still in the kseq buffer are not consumed yet,
+        //and a fasta header char already read belongs to the next record.
+        return gztell(kseq->f->f) - (kseq->f->end - kseq->f->begin) - (kseq->last_char != 0 ? 1 : 0);
+    }
+    if (getItem == &sequenceReader::getBamItem || getItem == &sequenceReader::getBamShardItem) {
+        return bgzf_tell(bam_file->fp.bgzf);
+    }
+    return -1;
+}
+
+bool cmri::sequenceReader::seek(int64_t position, int _count) {
+    if (position < 0) { return false; }
+    if (getItem == &sequenceReader::getFastxItem || getItem == &sequenceReader::getFastxShardItem) {
+        gzFile file = kseq->f->f;
+        //gzip streams seek by decompressing up to the position.
+        if (gzseek(file, position, SEEK_SET) < 0) { return false; }
+        kseq_destroy(kseq);
+        kseq = kseq_init(file);
+    } else if (getItem == &sequenceReader::getBamItem || getItem == &sequenceReader::getBamShardItem) {
+        if (bgzf_seek(bam_file->fp.bgzf, position, SEEK_SET) < 0) { return false; }
+    } else {
+        return false;
+    }
+    count = _count;
+    return true;
+}
+
+
+int cmri::sequenceReader::getTotalReads() {
+    if (total_reads < 0) { total_reads = count_reads(file_name); }
+    return total_reads;
+}
+
+double cmri::sequenceReader::getProgress() {
+    if (range_end <= range_begin) { return 0; }
+    const double consumed = static_cast<double>((this->*fileOffset)() - range_begin) / (range_end - range_begin);
+    return clip(consumed, 0.0, 1.0);
 }
 
 
 void cmri::read_item_t::clear() {
-    sequence = "";
+    //keeps the buffers capacity so they are reused by the next read.
+    sequence.clear();
+    raw_quality.clear();
     qvalue.clear();
+    qsum.clear();
     start = 0;
-    name = "";
+    name.clear();
+    tid = -1;
     end = 0;
     valid= false;
 }
+
+
+void cmri::read_item_t::decodeQuality() {
+    if (raw_quality.empty()) { //fasta and csv reads
+        qvalue.clear();
+        qsum.clear();
+        return;
+    }
+    qvalue.resize(raw_quality.size());
+    qsum.resize(raw_quality.size() + 1);
+    qsum[0] = 0;
+    for (size_t i = 0; i < raw_quality.size(); i++) {
+        uint8_t qv = static_cast<uint8_t>(raw_quality[i]) - quality_offset;
+        qvalue[i] = qv;
+        qsum[i + 1] = qsum[i] + qv;
+    }
+}
@@ -0,0 +1,115 @@
+//
+// Author(s) Pablo Galaviz (2020)
+// e-mail  <pgalaviz@cmri.org.au>
+//
+
+
+
+//  This file is part of GEAR
+//
+//  GEAR is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  any later version.
+//
+//  GEAR is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with GEAR.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// Reader throughput on a bam file: per base decoding (as sequenceReader used to do) against sequenceReader.
+// Usage: Bench_SequenceReader [bam file] [repetitions]
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include "sequenceReader.h"
+
+namespace {
+
+    struct bench_result_t {
+        size_t reads = 0;
+        size_t bases = 0;
+        double seconds = 0;
+    };
+
+    //one base at a time into a fresh string, qualities pushed into a vector of int, then copied into the item.
+    void legacyDecode(const std::string &file_name, bench_result_t &result) {
+
+        samFile *bam_file = hts_open(file_name.c_str(), "r");
+        bam_hdr_t *bam_header = sam_hdr_read(bam_file);
+        bam1_t *alignment = bam_init1();
+
+        std::string item_sequence;
+        std::vector<int> item_qvalue;
+        while (sam_read1(bam_file, bam_header, alignment) > 0) {
+            auto packed = bam_get_seq(alignment);
+            auto quality = bam_get_qual(alignment);
+            uint32_t len = alignment->core.l_qseq;
+            std::string sequence = "";
+            item_qvalue.clear();
+            for (uint32_t i = 0; i < len; i++) {
+                sequence += seq_nt16_str[bam_seqi(packed, i)];
+                item_qvalue.push_back(static_cast<int>(quality[i]));
+            }
+            item_sequence = sequence;
+            result.reads++;
+            result.bases += item_sequence.size();
+        }
+
+        bam_destroy1(alignment);
+        bam_hdr_destroy(bam_header);
+        sam_close(bam_file);
+    }
+
+    void readerDecode(const std::string &file_name, bench_result_t &result) {
+
+        cmri::sequenceReader reader(file_name, 0, 0);
+        cmri::read_item_t item;
+        while (reader.get(item)) {
+            if (!item.valid) { continue; }
+            result.reads++;
+            result.bases += item.sequence.size();
+        }
+        reader.close();
+    }
+
+    template<class F>
+    bench_result_t run(F decode, const std::string &file_name, int repetitions) {
+        bench_result_t result;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; i++) { decode(file_name, result); }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    void report(const std::string &label, const bench_result_t &result) {
+        std::cout << std::left << std::setw(10) << label
+                  << " reads: " << result.reads
+                  << " bases: " << result.bases
+                  << " time: " << result.seconds << " s"
+                  << " reads/s: " << result.reads / result.seconds
+                  << " Mbases/s: " << result.bases / result.seconds / 1e6 << std::endl;
+    }
+
+}
+
+
+int main(int argc, char *argv[]) {
+
+    std::string file_name = argc > 1 ? argv[1] : "data/input.bam";
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 1000;
+
+    auto legacy = run(legacyDecode, file_name, repetitions);
+    auto reader = run(readerDecode, file_name, repetitions);
+
+    report("legacy", legacy);
+    report("reader", reader);
+    std::cout << "speedup: " << legacy.seconds / reader.seconds << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include "../../src/Modules/MotifCount/approximateMatcher.h"
+
+
+BOOST_AUTO_TEST_SUITE(approximateMatcherTest)
+
+
+    typedef std::tuple<int32_t, size_t, size_t> hit_t; //pattern id, start, length
+
+    std::vector<hit_t> scanAll(const std::string &sequence, const cmri::approximateMatcher &matcher) {
+        std::vector<hit_t> result;
+        matcher.scan(sequence, [&](int32_t id, size_t start, size_t length) { result.emplace_back(id, start, length); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    //distance of the pattern to the best substring ending at each position, by dynamic programming.
+    std::vector<int> distances(const std::string &sequence, const std::string &pattern, cmri::distanceType distance) {
+        const size_t m = pattern.size();
+        std::vector<int> result(sequence.size(), 1 << 20);
+        if (distance == cmri::distanceType::hamming) {
+            for (size_t j = m - 1; j < sequence.size(); j++) {
+                int d = 0;
+                for (size_t i = 0; i < m; i++) { d += sequence[j + 1 - m + i] != pattern[i]; }
+                result[j] = d;
+            }
+            return result;
+        }
+        std::vector<int> column(m + 1);
+        for (size_t i = 0; i <= m; i++) { column[i] = static_cast<int>(i); }
+        for (size_t j = 0; j < sequence.size(); j++) {
+            int diagonal = column[0];
+            column[0] = 0;
+            for (size_t i = 1; i <= m; i++) {
+                int up = column[i];
+                column[i] = std::min({up + 1, column[i - 1] + 1, diagonal + (pattern[i - 1] != sequence[j])});
+                diagonal = up;
+            }
+            result[j] = column[m];
+        }
+        return result;
+    }
+
+    //hits chosen from the distances with the window rule of approximateMatcher.
+    std::vector<hit_t> reference(const std::string &sequence, const std::vector<std::string> &patterns,
+                                 cmri::distanceType distance, int max_distance) {
+        std::vector<hit_t> result;
+        for (size_t id = 0; id < patterns.size(); id++) {
+            const int64_t m = patterns[id].size();
+            auto d = distances(sequence, patterns[id], distance);
+            const int64_t min_length = distance == cmri::distanceType::edit ? m - max_distance : m;
+            const int64_t window = std::min<int64_t>(min_length, 2 * max_distance + 1);
+            int64_t next_end = 0;
+            int64_t last_end = -1;
+            for (int64_t j = 0; j < static_cast<int64_t>(sequence.size()); j++) {
+                if (d[j] > max_distance || j < next_end) { continue; }
+                int64_t best = j;
+                for (int64_t w = j; w < std::min<int64_t>(j + window, sequence.size()); w++) {
+                    if (d[w] < d[best]) { best = w; }
+                }
+                const int64_t start = std::max<int64_t>(best + 1 - m, last_end + 1);
+                result.emplace_back(id, start, best + 1 - start);
+                next_end = best + min_length;
+                last_end = best;
+                j = std::max(j, best);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+
+    BOOST_AUTO_TEST_CASE(exactTest) {
+
+        std::vector<std::string> motifs = {"TTAGGG", "TCAGGG", "AA"};
+        std::string sequence = "TTAGGGTTAGGGTCAGGGAAAAATTAGGGNTTAGG";
+        for (auto distance : {cmri::distanceType::hamming, cmri::distanceType::edit}) {
+            cmri::approximateMatcher matcher(motifs, distance, 0);
+            auto hits = scanAll(sequence, matcher);
+            //same non overlapping hits as the exact motifs.
+            std::vector<hit_t> expected = {{0, 0, 6}, {0, 6, 6}, {0, 23, 6}, {1, 12, 6}, {2, 18, 2}, {2, 20, 2}};
+            BOOST_TEST((hits == expected));
+        }
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(telomereTest) {
+
+        std::string sequence = "TTAGGGTTAGGGTTCGGGTTAGGTTAGGG";
+        cmri::approximateMatcher hamming({"TTAGGG"}, cmri::distanceType::hamming, 1);
+        auto hits = scanAll(sequence, hamming);
+        //the mismatch is found, the unit with a deleted base shifts the next one.
+        std::vector<hit_t> expected = {{0, 0, 6}, {0, 6, 6}, {0, 12, 6}, {0, 18, 6}};
+        BOOST_TEST((hits == expected));
+
+        cmri::approximateMatcher edit({"TTAGGG"}, cmri::distanceType::edit, 1);
+        hits = scanAll(sequence, edit);
+        expected = {{0, 0, 6}, {0, 6, 6}, {0, 12, 6}, {0, 18, 5}, {0, 23, 6}};
+        BOOST_TEST((hits == expected));
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(randomTest) {
+
+        std::vector<std::vector<std::string>> pattern_sets = {
+                {"TTAGGG", "CCCTAA", "TCAGGG"},
+                {"ACGTACGTAC", "GGGG"},
+                {"TTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAG"}};
+
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> base(0, 4);
+        for (auto &patterns : pattern_sets) {
+            for (auto distance : {cmri::distanceType::hamming, cmri::distanceType::edit}) {
+                for (int max_distance = 0; max_distance < 4; max_distance++) {
+                    cmri::approximateMatcher matcher(patterns, distance, max_distance);
+                    for (int n = 0; n < 50; n++) {
+                        //mutated copies of the patterns between random bases.
+                        std::string sequence;
+                        for (int i = 0; i < 40; i++) {
+                            if (base(generator) == 0) {
+                                std::string copy = patterns[generator() % patterns.size()];
+                                copy[generator() % copy.size()] = "ACGTN"[base(generator)];
+                                sequence += copy;
+                            } else {
+                                sequence += "ACGTN"[base(generator) % 4];
+                            }
+                        }
+                        auto hits = scanAll(sequence, matcher);
+                        BOOST_TEST((hits == reference(sequence, patterns, distance, max_distance)));
+                    }
+                }
+            }
+        }
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(supportsTest) {
+
+        BOOST_TEST(cmri::approximateMatcher::supports({"TTAGGG"}, 5));
+        BOOST_TEST(!cmri::approximateMatcher::supports({"TTAGGG"}, 6));
+        BOOST_TEST(!cmri::approximateMatcher::supports({""}, 0));
+        BOOST_TEST(!cmri::approximateMatcher::supports({std::string(65, 'A')}, 1));
+        BOOST_TEST(!cmri::approximateMatcher::supports({"TTAGGG"}, -1));
+
+    }
+
+
+BOOST_AUTO_TEST_SUITE_END()
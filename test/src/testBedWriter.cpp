@@ -0,0 +1,132 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "bedWriter.h"
+#include <tbx.h>
+#include <zlib.h>
+#include <cstdio>
+#include <fstream>
+
+
+BOOST_AUTO_TEST_SUITE(bedWriterTest)
+
+    std::string readBed(const std::string &file_name) {
+        std::ifstream file(file_name);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string readBgzf(const std::string &file_name) {
+        gzFile file = gzopen(file_name.c_str(), "r");
+        std::string result;
+        char buffer[4096];
+        int read;
+        while ((read = gzread(file, buffer, sizeof(buffer))) > 0) { result.append(buffer, read); }
+        gzclose(file);
+        return result;
+    }
+
+    //lines of the bed.gz file overlapping chromosome:begin-end, found through its tabix index.
+    std::vector<std::string> queryTabix(const std::string &file_name, const std::string &chromosome, int begin, int end) {
+        std::vector<std::string> result;
+        htsFile *file = hts_open(file_name.c_str(), "r");
+        tbx_t *index = tbx_index_load(file_name.c_str());
+        BOOST_REQUIRE(file != nullptr);
+        BOOST_REQUIRE(index != nullptr);
+        hts_itr_t *iterator = tbx_itr_queryi(index, tbx_name2id(index, chromosome.c_str()), begin, end);
+        kstring_t line = {0, 0, nullptr};
+        while (iterator != nullptr && tbx_itr_next(file, index, iterator, &line) >= 0) { result.emplace_back(line.s); }
+        free(line.s);
+        tbx_itr_destroy(iterator);
+        tbx_destroy(index);
+        hts_close(file);
+        return result;
+    }
+
+    BOOST_AUTO_TEST_CASE(testBedWriter) {
+
+        cmri::bedWriter bed_writer("testBedWriter.bed");
+        bed_writer.append("chr1", 10, 22, "TTAGGG", 2, true, 0, 0, 0, 255, 0);
+        bed_writer.append("chr2", 0, 6, "TCAGGG", 1, false, 1, 5);
+        //nothing is written before close (buffered).
+        BOOST_TEST(readBed(bed_writer.getFileName()).empty());
+        BOOST_TEST(bed_writer.close());
+
+        BOOST_TEST(readBed(bed_writer.getFileName()) ==
+                   "#chrom\tchromStart\tchromEnd\tname\tscore\tstrand\tthickStart\tthickEnd\titemRgb\n"
+                   "chr1\t10\t22\tTTAGGG\t2\t+\t10\t22\t0,255,0\n"
+                   "chr2\t0\t6\tTCAGGG\t1\t-\t1\t5\t255,0,0\n");
+        std::remove(bed_writer.getFileName().c_str());
+
+    }
+
+    BOOST_AUTO_TEST_CASE(testBedWriterNoRgb) {
+
+        cmri::bedWriter bed_writer("testBedWriterNoRgb.bed", false, false);
+        bed_writer.append("chr1", 100, 200, "Telomere", 900, true, 120, 180);
+        BOOST_TEST(bed_writer.close());
+
+        BOOST_TEST(readBed(bed_writer.getFileName()) ==
+                   "#chrom\tchromStart\tchromEnd\tname\tscore\tstrand\tthickStart\tthickEnd\n"
+                   "chr1\t100\t200\tTelomere\t900\t+\t120\t180\n");
+        std::remove(bed_writer.getFileName().c_str());
+
+    }
+
+    BOOST_AUTO_TEST_CASE(testBedWriterTabix) {
+
+        cmri::bedWriter bed_writer("testBedWriterTabix.bed", true, false);
+        //starts out of order within each chromosome, as the variant runs of a region are.
+        bed_writer.append("chr1", 500, 520, "TTAGGG", 1);
+        bed_writer.append("chr1", 100, 130, "TTAGGG", 2);
+        bed_writer.append("chr1", 300, 306, "TCAGGG", 3);
+        bed_writer.append("chr2", 50, 62, "TTAGGG", 4);
+        bed_writer.append("chr2", 10, 16, "TCAGGG", 5);
+        BOOST_TEST(bed_writer.close());
+        BOOST_TEST(bed_writer.getFileName() == "testBedWriterTabix.bed.gz");
+
+        //records are written sorted by start within each chromosome.
+        BOOST_TEST(readBgzf(bed_writer.getFileName()) ==
+                   "#chrom\tchromStart\tchromEnd\tname\tscore\tstrand\tthickStart\tthickEnd\n"
+                   "chr1\t100\t130\tTTAGGG\t2\t+\t100\t130\n"
+                   "chr1\t300\t306\tTCAGGG\t3\t+\t300\t306\n"
+                   "chr1\t500\t520\tTTAGGG\t1\t+\t500\t520\n"
+                   "chr2\t10\t16\tTCAGGG\t5\t+\t10\t16\n"
+                   "chr2\t50\t62\tTTAGGG\t4\t+\t50\t62\n");
+
+        std::vector<std::string> chr1 = {"chr1\t100\t130\tTTAGGG\t2\t+\t100\t130",
+                                         "chr1\t300\t306\tTCAGGG\t3\t+\t300\t306",
+                                         "chr1\t500\t520\tTTAGGG\t1\t+\t500\t520"};
+        BOOST_TEST(queryTabix(bed_writer.getFileName(), "chr1", 0, 1000) == chr1);
+        std::vector<std::string> chr1_300 = {"chr1\t300\t306\tTCAGGG\t3\t+\t300\t306"};
+        BOOST_TEST(queryTabix(bed_writer.getFileName(), "chr1", 290, 310) == chr1_300);
+        std::vector<std::string> chr2_10 = {"chr2\t10\t16\tTCAGGG\t5\t+\t10\t16"};
+        BOOST_TEST(queryTabix(bed_writer.getFileName(), "chr2", 0, 20) == chr2_10);
+        BOOST_TEST(queryTabix(bed_writer.getFileName(), "chr2", 20, 40).empty());
+
+        std::remove(bed_writer.getFileName().c_str());
+        std::remove((bed_writer.getFileName() + ".tbi").c_str());
+
+    }
+
+    BOOST_AUTO_TEST_CASE(testBedWriterTabixRepeatedChromosome) {
+
+        std::remove("testBedWriterRepeated.bed.gz.tbi");
+        cmri::bedWriter bed_writer("testBedWriterRepeated.bed", true, false);
+        bed_writer.append("chr1", 100, 130, "TTAGGG", 1);
+        bed_writer.append("chr2", 10, 16, "TTAGGG", 2);
+        bed_writer.append("chr1", 50, 56, "TTAGGG", 3);
+        BOOST_TEST(bed_writer.close());
+
+        //the records are all written, the index is dropped as chr1 is not contiguous.
+        BOOST_TEST(readBgzf(bed_writer.getFileName()) ==
+                   "#chrom\tchromStart\tchromEnd\tname\tscore\tstrand\tthickStart\tthickEnd\n"
+                   "chr1\t100\t130\tTTAGGG\t1\t+\t100\t130\n"
+                   "chr2\t10\t16\tTTAGGG\t2\t+\t10\t16\n"
+                   "chr1\t50\t56\tTTAGGG\t3\t+\t50\t56\n");
+        BOOST_TEST(!std::ifstream(bed_writer.getFileName() + ".tbi").good());
+
+        std::remove(bed_writer.getFileName().c_str());
+
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
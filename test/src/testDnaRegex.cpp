@@ -0,0 +1,63 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+#include <random>
+#include "../../src/Modules/MotifCount/dnaRegex.h"
+
+
+BOOST_AUTO_TEST_SUITE(dnaRegexTest)
+
+
+    //(start, length) of the matches found searching again on the suffix of every match.
+    std::vector<std::pair<size_t, size_t>> suffixSearch(std::string sequence, const std::string &pattern) {
+        std::vector<std::pair<size_t, size_t>> result;
+        std::regex basic_regex(pattern);
+        std::smatch match;
+        size_t offset = 0;
+        while (std::regex_search(sequence, match, basic_regex)) {
+            result.emplace_back(offset + match.position(), match.length());
+            offset += match.position() + match.length();
+            sequence = match.suffix().str();
+        }
+        return result;
+    }
+
+    std::vector<std::pair<size_t, size_t>> scan(const std::string &sequence, const cmri::dnaRegex &regex) {
+        std::vector<std::pair<size_t, size_t>> result;
+        regex.scan(sequence, [&](size_t start, size_t length) { result.emplace_back(start, length); });
+        return result;
+    }
+
+
+    std::string sample_pattern[] = {"(TCAGGG){1}(TTAGGG){2}", "A(.{1})AGGG", "A(.{2})AGGG", "(TTAGGG)(.{1})(TCAGGG)",
+                                    "(TTAGGG)(.{3})(TCAGGG)", "(?:TTAGGG|TCAGGG|TGAGGG)[AG]", "[^T]{2}GG",
+                                    "(TTAGGG)+", "TTA|TTAGGG", "^TTAGGG", "(TTAGGG)(.{0,2})TCAGGG"};
+    bool sample_dfa[] = {true, true, true, true, true, true, true, false, false, false, false};
+    std::string sample_literal[] = {"TCAGGGTTAGGGTTAGGG", "AGGG", "AGGG", "TTAGGG", "TTAGGG", "", "GG", "", "", "",
+                                    "TTAGGG"};
+
+    BOOST_DATA_TEST_CASE(scanTest,
+                         boost::unit_test::data::make(sample_pattern) ^ sample_dfa ^ sample_literal,
+                         pattern, dfa, literal) {
+
+        cmri::dnaRegex regex(pattern);
+        BOOST_TEST(regex.isDfa() == dfa);
+        BOOST_TEST(regex.getLiteral() == literal);
+
+        std::string sequence = "TTAGGGCTTAGGGAAATTAGGGCCCTTAGGGACTTTAGGGTTAGGGTTAACCCTCAGGGTTAGGGTTAGGGTGAGGGA";
+        BOOST_TEST(scan(sequence, regex) == suffixSearch(sequence, pattern));
+
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<int> repeat(0, 5);
+        const char *blocks[] = {"TTAGGG", "TCAGGG", "TGAGGG", "A", "C", "N"};
+        for (int n = 0; n < 100; n++) {
+            std::string random_sequence;
+            for (int i = 0; i < 40; i++) { random_sequence += blocks[repeat(generator)]; }
+            BOOST_TEST(scan(random_sequence, regex) == suffixSearch(random_sequence, pattern));
+        }
+
+    }
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include "intervalIndex.h"
+
+
+BOOST_AUTO_TEST_SUITE(intervalIndexTest)
+
+
+    std::vector<int> findAll(const cmri::intervalIndex<int> &index, int64_t position) {
+        std::vector<int> result;
+        index.find(position, [&](int value) { result.push_back(value); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+
+    BOOST_AUTO_TEST_CASE(findTest) {
+
+        cmri::intervalIndex<int> index;
+        index.add(10, 20, 0);
+        index.add(15, 15, 1);
+        index.add(0, 100, 2);
+        index.add(30, 40, 3);
+        index.index();
+
+        BOOST_TEST(findAll(index, 5) == std::vector<int>({2}));
+        BOOST_TEST(findAll(index, 10) == std::vector<int>({0, 2}));
+        BOOST_TEST(findAll(index, 15) == std::vector<int>({0, 1, 2}));
+        BOOST_TEST(findAll(index, 20) == std::vector<int>({0, 2}));
+        BOOST_TEST(findAll(index, 21) == std::vector<int>({2}));
+        BOOST_TEST(findAll(index, 101).empty());
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(randomTest) {
+
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int64_t> position(0, 10000);
+        std::uniform_int_distribution<int64_t> length(0, 500);
+
+        for (int n : {1, 7, 64, 1000}) {
+            cmri::intervalIndex<int> index;
+            std::vector<std::pair<int64_t, int64_t>> intervals;
+            for (int i = 0; i < n; i++) {
+                int64_t start = position(generator);
+                int64_t end = start + length(generator);
+                index.add(start, end, i);
+                intervals.emplace_back(start, end);
+            }
+            index.index();
+            BOOST_TEST(index.size() == static_cast<size_t>(n));
+
+            for (int q = 0; q < 500; q++) {
+                int64_t query = position(generator);
+                std::vector<int> expected;
+                for (int i = 0; i < n; i++) {
+                    if (intervals[i].first <= query && query <= intervals[i].second) { expected.push_back(i); }
+                }
+                BOOST_TEST(findAll(index, query) == expected);
+            }
+        }
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(emptyTest) {
+
+        cmri::intervalIndex<int> index;
+        index.index();
+        BOOST_TEST(index.empty());
+        BOOST_TEST(findAll(index, 0).empty());
+
+    }
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include "jsonWriter.h"
+#include "../../src/Modules/MotifCount/motifRegion.h"
+#include <cstdio>
+#include <zlib.h>
+#include <fstream>
+
+
+BOOST_AUTO_TEST_SUITE(jsonWriterTest)
+
+    std::string readFile(const std::string &file_name, bool gzip) {
+        std::ifstream file(file_name, std::ios_base::in | std::ios_base::binary);
+        boost::iostreams::filtering_streambuf<boost::iostreams::input> inbuf;
+        if (gzip) { inbuf.push(boost::iostreams::gzip_decompressor()); }
+        inbuf.push(file);
+        std::istream instream(&inbuf);
+        return std::string(std::istreambuf_iterator<char>(instream), std::istreambuf_iterator<char>());
+    }
+
+    BOOST_AUTO_TEST_CASE(testJsonWriter) {
+
+        std::stringstream input_data;
+        input_data << R"({"chr1":[{"start":1,"end":100,"name":"p_telomere","count":0,"total_bases":0,)"
+                   << R"("motifs":{"CCCTAA":0,"TTAGGG":0},"regex":{"(TTAGGG){2}":0}}],)"
+                   << R"("unmapped":[{"start":0,"end":0,"name":"unmapped","count":0,"total_bases":0,)"
+                   << R"("motifs":{"TTAGGG":0},"regex":{}}]})";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(input_data, input_tree);
+        cmri::mapVectorMotifRegion regions;
+        cmri::deserialize(input_tree, regions);
+        regions["chr1"][0].motif_counts.add(1, 30);
+        regions["chr1"][0].reads_count = 5;
+
+        //the streamed document is the same as the serialized string, plain or compressed.
+        const std::string expected = cmri::serialize(regions);
+        for (bool gzip : {false, true}) {
+            cmri::jsonWriter output("testJsonWriter.json", gzip);
+            output.write(regions);
+            BOOST_TEST(output.close());
+            BOOST_TEST(readFile(output.getFileName(), gzip) == expected);
+            std::remove(output.getFileName().c_str());
+        }
+
+        std::vector<std::map<std::string, int>> values{{{"a", 1}, {"b", 2}}, {}};
+        BOOST_TEST(cmri::serialize(values) == R"([{"a":1,"b":2},{}])");
+        BOOST_TEST(cmri::escape_json("q\"\x01") == "q\\u0022\\u0001");
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(testJsonWriterLines) {
+
+        std::vector<std::map<std::string, int>> records{{{"TTAGGG", 3}}, {}, {{"TCAGGG", 1}, {"TTAGGG", 2}}};
+        cmri::jsonWriter output("testJsonWriterLines.ndjson", cmri::compression_t::gzip);
+        for (auto &record : records) { output.writeLine(record); }
+        BOOST_TEST(output.close());
+        BOOST_TEST(readFile(output.getFileName(), true) == "{\"TTAGGG\":3}\n{}\n{\"TCAGGG\":1,\"TTAGGG\":2}\n");
+        std::remove(output.getFileName().c_str());
+
+    }
+
+    //bgzf files are read back with zlib, which reads every block (gzip member).
+    BOOST_AUTO_TEST_CASE(testJsonWriterBgzf) {
+
+        std::string expected;
+        cmri::jsonWriter output("testJsonWriterBgzf.ndjson", cmri::compression_t::bgzf);
+        for (int i = 0; i < 20000; i++) {
+            std::map<std::string, int> record{{"read", i}};
+            output.writeLine(record);
+            expected += cmri::serialize(record) + "\n";
+        }
+        BOOST_TEST(output.close());
+
+        gzFile file = gzopen(output.getFileName().c_str(), "r");
+        std::string result;
+        char buffer[4096];
+        int read;
+        while ((read = gzread(file, buffer, sizeof(buffer))) > 0) { result.append(buffer, read); }
+        gzclose(file);
+        BOOST_TEST(result == expected);
+        std::remove(output.getFileName().c_str());
+
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
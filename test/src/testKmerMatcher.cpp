@@ -0,0 +1,83 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include "../../src/Modules/MotifCount/kmerMatcher.h"
+#include "../../src/Modules/MotifCount/motifMatcher.h"
+
+
+BOOST_AUTO_TEST_SUITE(kmerMatcherTest)
+
+
+    template<class M>
+    std::vector<std::pair<int32_t, size_t>> scanAll(const std::string &sequence, const M &matcher) {
+        std::vector<std::pair<int32_t, size_t>> result;
+        matcher.scan(sequence, [&](int32_t id, size_t start) { result.emplace_back(id, start); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<cmri::baseKernel> kernels() {
+        std::vector<cmri::baseKernel> result;
+        for (auto kernel : {cmri::baseKernel::scalar, cmri::baseKernel::sse41, cmri::baseKernel::avx2}) {
+            if (cmri::supportedBaseKernel(kernel)) { result.push_back(kernel); }
+        }
+        return result;
+    }
+
+
+    BOOST_AUTO_TEST_CASE(encodeTest) {
+
+        std::string sequence;
+        for (int i = 0; i < 256; i++) { sequence += static_cast<char>(i); }
+        sequence += "ACGTNacgtACGTACGTACGTACGTACGTACGTACGTACGT";
+
+        for (auto kernel : kernels()) {
+            std::vector<uint8_t> codes(sequence.size());
+            cmri::encodeBases(sequence.data(), sequence.size(), codes.data(), kernel);
+            for (size_t i = 0; i < sequence.size(); i++) {
+                auto expected = std::string("ACGT").find(sequence[i]);
+                BOOST_TEST(codes[i] == (expected == std::string::npos ? 4 : expected));
+            }
+        }
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(scanTest) {
+
+        std::vector<std::vector<std::string>> motif_sets = {
+                {"TTAGGG", "TCAGGG", "TGAGGG", "TTGGGG"},
+                {"A", "AA", "CCCTAA", "CCCTAACCCTAACCCTAACCCTAACCCTAACC", "TTAGGGTTAGGGT"}};
+
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> base(0, 9);
+        for (auto &motifs : motif_sets) {
+            BOOST_TEST(cmri::kmerMatcher::supports(motifs));
+            cmri::motifMatcher reference(motifs);
+            for (auto kernel : kernels()) {
+                cmri::kmerMatcher matcher(motifs, kernel);
+                for (int n = 0; n < 200; n++) {
+                    std::string sequence;
+                    for (int i = 0; i < 5 + n; i++) { sequence += "ACGTACGTNa"[base(generator)]; }
+                    sequence += "CCCTAACCCTAACCCTAACCCTAACCCTAACCTTAGGGTTAGGGTTAGGGT";
+                    BOOST_TEST(scanAll(sequence, matcher) == scanAll(sequence, reference));
+                }
+            }
+        }
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(supportsTest) {
+
+        BOOST_TEST(!cmri::kmerMatcher::supports({"TTAGGN"}));
+        BOOST_TEST(!cmri::kmerMatcher::supports({"ttaggg"}));
+        BOOST_TEST(!cmri::kmerMatcher::supports({""}));
+        BOOST_TEST(!cmri::kmerMatcher::supports({std::string(33, 'A')}));
+        BOOST_TEST(cmri::kmerMatcher::supports({std::string(32, 'A')}));
+
+    }
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -34,7 +34,7 @@ BOOST_AUTO_TEST_SUITE(motifCountTest)
                                "TTAGGG"
                                "TTAGGG"
                                "TTAACCC";
-        std::vector<int> quality={1,1,1,1,1,1
+        std::vector<uint8_t> quality={1,1,1,1,1,1
                                   ,7
                                   ,5,5,6,6,6,6
                                   ,3,3,2
@@ -55,8 +55,8 @@ BOOST_AUTO_TEST_SUITE(motifCountTest)
         }}};
         std::map<std::string,std::map<unsigned int,unsigned int>> expected = {{"TTAGGG",{
                          {1,2}
-                        ,{5,2}
-                        ,{6,0}
+                        ,{5,0}
+                        ,{6,2}
                         ,{10,1}
                         ,{13,1}
                 }}};;
@@ -69,6 +69,63 @@ BOOST_AUTO_TEST_SUITE(motifCountTest)
     }
 
 
+    BOOST_AUTO_TEST_CASE(strandAwareTest) {
+
+        std::stringstream input_data;
+        input_data << "{\"start\":0,\"end\":0,\"name\":\"telomere\",\"count\":0,\"total_bases\":0,\"strand_aware\":true,"
+                      "\"motifs\":{\"TTAGGG\":0,\"ACGT\":0,\"TTAGGN\":0},\"regex\":{}}";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(input_data, input_tree);
+
+        cmri::motifRegion region;
+        region.deserialize(input_tree);
+        BOOST_TEST(region.strand_aware);
+        BOOST_TEST(region.motif_counts.patterns() == 6);
+
+        //motifs are sorted: ACGT (palindrome), TTAGGG, TTAGGN.
+        std::string sequence = "TTAGGGTTAGGGCCCTAACCCTAACCCTAAACGTTTAGGN";
+        std::vector<uint8_t> quality(sequence.size(), 20);
+        std::vector<uint32_t> quality_sum;
+        cmri::qualityPrefixSum(quality, quality_sum);
+        cmri::searchMotifWFilter(*region.motif_matcher, sequence, quality_sum, region.motif_counts);
+        BOOST_TEST(region.motif_counts.get(0, 20) == 1);
+        BOOST_TEST(region.motif_counts.get(1, 20) == 2);
+        BOOST_TEST(region.motif_counts.get(2, 20) == 1);
+        BOOST_TEST(region.motif_counts.get(3, 20) == 1);
+        BOOST_TEST(region.motif_counts.get(4, 20) == 3);
+        BOOST_TEST(region.motif_counts.get(5, 20) == 0);
+
+        //both strands of each motif in the output, the flag survives a round trip.
+        boost::property_tree::ptree output_tree;
+        std::stringstream output_data(region.serialize());
+        boost::property_tree::read_json(output_data, output_tree);
+        BOOST_TEST(output_tree.get<bool>("strand_aware"));
+        BOOST_TEST(output_tree.get<unsigned int>("motifs.TTAGGG.forward.20") == 2);
+        BOOST_TEST(output_tree.get<unsigned int>("motifs.TTAGGG.reverse.20") == 3);
+
+        cmri::motifRegion copy;
+        copy.deserialize(output_tree);
+        BOOST_TEST(copy.strand_aware);
+        BOOST_TEST(copy.motifs == region.motifs);
+
+        //literal only motifs use the k-mer kernel, same counts.
+        std::stringstream literal_data;
+        literal_data << "{\"start\":0,\"end\":0,\"name\":\"telomere\",\"count\":0,\"total_bases\":0,\"strand_aware\":true,"
+                        "\"motifs\":{\"TTAGGG\":0,\"ACGT\":0},\"regex\":{}}";
+        boost::property_tree::ptree literal_tree;
+        boost::property_tree::read_json(literal_data, literal_tree);
+        cmri::motifRegion literal;
+        literal.deserialize(literal_tree);
+        BOOST_TEST(literal.kmer_matcher != nullptr);
+        cmri::searchMotifWFilter(*literal.kmer_matcher, sequence, quality_sum, literal.motif_counts);
+        for (unsigned int id : {0, 1}) {
+            BOOST_TEST(literal.motif_counts.get(id, 20) == region.motif_counts.get(id, 20));
+            BOOST_TEST(literal.motif_counts.get(2 + id, 20) == region.motif_counts.get(3 + id, 20));
+        }
+
+    }
+
+
     std::string sample_regex_motif[] = {"(TTAGGG)(.{0})TTAGGG", "(TTAGGG)(.{1})TTAGGG", "(TTAGGG)(.{3})TTAGGG"};
     int sample_expected[] = {1, 1, 2};
 
@@ -154,5 +211,247 @@ BOOST_AUTO_TEST_SUITE(motifCountTest)
         BOOST_TEST(motifs == result);
     }
 
+    //motifRegion::operator== compares coordinates and totals only, the counters are compared row by row.
+    std::vector<unsigned int> histogramRow(const cmri::qvHistogram &histogram, size_t id) {
+        std::vector<unsigned int> row;
+        for (unsigned int bin = 0; bin < cmri::qvHistogram::bins; bin++) { row.push_back(histogram.get(id, bin)); }
+        return row;
+    }
+
+    void checkCounts(const cmri::vectorMotifRegion &regions, const cmri::vectorMotifRegion &expected) {
+        BOOST_REQUIRE(regions.size() == expected.size());
+        for (size_t i = 0; i < regions.size(); i++) {
+            BOOST_REQUIRE(regions[i].motif_counts.patterns() == expected[i].motif_counts.patterns());
+            BOOST_REQUIRE(regions[i].regex_counts.patterns() == expected[i].regex_counts.patterns());
+            for (size_t id = 0; id < expected[i].motif_counts.patterns(); id++) {
+                BOOST_TEST(histogramRow(regions[i].motif_counts, id) == histogramRow(expected[i].motif_counts, id),
+                           regions[i].name << " motif " << id);
+            }
+            for (size_t id = 0; id < expected[i].regex_counts.patterns(); id++) {
+                BOOST_TEST(histogramRow(regions[i].regex_counts, id) == histogramRow(expected[i].regex_counts, id),
+                           regions[i].name << " regex " << id);
+            }
+        }
+    }
+
+    //counts of the whole bam file read sequentially.
+    cmri::mapVectorMotifRegion fullScan() {
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json("data/input.json", input_tree);
+        cmri::mapVectorMotifRegion motifs;
+        cmri::deserialize(input_tree, motifs);
+
+        cmri::common_options_t common_options;
+        common_options.input_file = "data/input.bam";
+        cmri::motif_count_options_t motif_count_options;
+        motif_count_options.quality_value = 10;
+        motif_count_options.quality_map = 30;
+        cmri::process(common_options, motif_count_options, motifs);
+        return motifs;
+    }
+
+    BOOST_AUTO_TEST_CASE(processIndexedTest){
+
+        std::string motif_file = "data/input.json";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(motif_file, input_tree);
+        std::map<std::string, std::vector<cmri::motifRegion>> motifs;
+        cmri::deserialize(input_tree,motifs);
+
+        boost::property_tree::ptree result_tree;
+        boost::property_tree::read_json("data/bam_result.json", result_tree);
+        std::map<std::string, std::vector<cmri::motifRegion>> result;
+        cmri::deserialize(result_tree,result);
+
+        cmri::common_options_t common_options;
+        common_options.input_file="data/input.bam";
+        cmri::motif_count_options_t motif_count_options;
+        motif_count_options.quality_value=10;
+        motif_count_options.quality_map=30;
+        motif_count_options.indexed=true;
+        cmri::process(common_options,motif_count_options, motifs);
+
+        //only reads overlapping the regions and the unmapped tail are read.
+        BOOST_TEST(motifs["motif_test"] == result["motif_test"]);
+        BOOST_TEST(motifs["regex_test"] == result["regex_test"]);
+        BOOST_TEST(motifs["unmapped"] == result["unmapped"]);
+
+        auto expected = fullScan();
+        for (auto name : {"motif_test", "regex_test", "unmapped"}) { checkCounts(motifs[name], expected[name]); }
+    }
+
+
+    std::string sample_partition[] = {"contig", "tile"};
+
+    BOOST_DATA_TEST_CASE(processPartitionsTest,boost::unit_test::data::make(sample_partition),partition){
+
+        std::string motif_file = "data/input.json";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(motif_file, input_tree);
+        std::map<std::string, std::vector<cmri::motifRegion>> motifs;
+        cmri::deserialize(input_tree,motifs);
+
+        boost::property_tree::ptree result_tree;
+        boost::property_tree::read_json("data/bam_result.json", result_tree);
+        std::map<std::string, std::vector<cmri::motifRegion>> result;
+        cmri::deserialize(result_tree,result);
+
+        cmri::common_options_t common_options;
+        common_options.input_file="data/input.bam";
+        common_options.threads = 4;
+        common_options.chunk_size = 3;
+        cmri::motif_count_options_t motif_count_options;
+        motif_count_options.quality_value=10;
+        motif_count_options.quality_map=30;
+        motif_count_options.partition=partition;
+        motif_count_options.tile_size=1000;
+        cmri::processPartitions(common_options,motif_count_options, motifs);
+
+        //every read is counted once, whatever the partitions.
+        BOOST_TEST(motifs == result);
+        auto expected = fullScan();
+        for (auto &item : expected) { checkCounts(motifs[item.first], item.second); }
+    }
+
+
+    BOOST_AUTO_TEST_CASE(getPartitionsTest){
+
+        std::map<std::string, std::vector<cmri::motifRegion>> motifs;
+        motifs["chr2"];
+        std::vector<std::string> names = {"chr1", "chr2"};
+        std::vector<int64_t> lengths = {2500, 1000};
+
+        cmri::motif_count_options_t motif_count_options;
+        motif_count_options.partition="tile";
+        motif_count_options.tile_size=1000;
+        auto partitions = cmri::getPartitions(names, lengths, motifs, motif_count_options);
+        BOOST_TEST(partitions.size() == 5);
+        BOOST_TEST(partitions[0].tid == 0);
+        BOOST_TEST(partitions[1].begin == 1000);
+        BOOST_TEST(partitions[1].end == 2000);
+        BOOST_TEST(partitions[2].begin == 2000);
+        BOOST_TEST(partitions[2].end >= 2500);
+        BOOST_TEST(partitions[3].tid == 1);
+        BOOST_TEST(partitions[4].tid == -1);
+
+        motif_count_options.partition="contig";
+        motif_count_options.indexed=true;
+        motif_count_options.unmapped=false;
+        partitions = cmri::getPartitions(names, lengths, motifs, motif_count_options);
+        BOOST_TEST(partitions.size() == 1);
+        BOOST_TEST(partitions[0].tid == 1);
+        BOOST_TEST(partitions[0].begin == 0);
+    }
+
+
+    BOOST_AUTO_TEST_CASE(approximateRegionTest){
+
+        std::stringstream input_data;
+        input_data << R"({"start":0,"end":0,"name":"other","count":0,"total_bases":0,"motifs":{},"regex":{},)"
+                   << R"("distance":"edit","max_distance":1,"approximate":{"TTAGGG":0}})";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(input_data, input_tree);
+        cmri::motifRegion region;
+        region.deserialize(input_tree);
+        BOOST_TEST(region.approximate.size() == 1);
+        BOOST_TEST((region.distance == cmri::distanceType::edit));
+        BOOST_REQUIRE(region.approximate_matcher);
+
+        //one substitution and one deletion, without qualities every hit goes to bin 0.
+        cmri::searchApproximate(*region.approximate_matcher, "TTAGGGTTCGGGTTAGGTTAGGG", {}, region.approximate_counts);
+        BOOST_TEST(region.approximate_counts.get(0, 0) == 4);
+
+        auto serialized = region.serialize();
+        BOOST_TEST(serialized.find(R"("distance":"edit","max_distance":1,"approximate":{"TTAGGG" : {"0":4,)") !=
+                   std::string::npos);
+    }
+
+
+    BOOST_AUTO_TEST_CASE(repeatRegionTest){
+
+        std::stringstream input_data;
+        input_data << R"({"start":0,"end":0,"name":"other","count":0,"total_bases":0,"motifs":{},"regex":{},)"
+                   << R"("strand_aware":true,"min_repeats":2,"repeats":{"TTAGGG":0}})";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(input_data, input_tree);
+        cmri::motifRegion region;
+        region.deserialize(input_tree);
+        BOOST_REQUIRE(region.repeat_matcher);
+
+        cmri::searchRepeats(*region.repeat_matcher, "TTAGGGTTAGGGTTAGGGACCCTAACCCTAATTAGGG", region.repeat_counts);
+        cmri::searchRepeats(*region.repeat_matcher, "TTAGGGTTAGGG", region.repeat_counts);
+        BOOST_TEST(region.repeat_counts.get(0, 3) == 1);
+        BOOST_TEST(region.repeat_counts.get(0, 2) == 1);
+        BOOST_TEST(region.repeat_counts.get(0, 1) == 0);
+        BOOST_TEST(region.repeat_counts.get(1, 2) == 1);
+
+        auto serialized = region.serialize();
+        BOOST_TEST(serialized.find(R"("repeats":{"TTAGGG" : {"forward":{"2":1,"3":1},"reverse":{"2":1}}})") !=
+                   std::string::npos);
+
+        //run lengths survive a checkpoint.
+        std::stringstream binary;
+        region.writeCounts(binary);
+        auto restored = region;
+        restored.resetCount();
+        BOOST_TEST(restored.readCounts(binary));
+        BOOST_TEST((restored.repeat_counts == region.repeat_counts));
+    }
+
+
+    std::string sample_checkpoint[] = {"process", "multithreading"};
+
+    BOOST_DATA_TEST_CASE(checkpointResumeTest,boost::unit_test::data::make(sample_checkpoint),mode){
+
+        std::string motif_file = "data/input.json";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(motif_file, input_tree);
+        std::map<std::string, std::vector<cmri::motifRegion>> motifs;
+        cmri::deserialize(input_tree,motifs);
+        auto resumed = motifs;
+
+        boost::property_tree::ptree result_tree;
+        boost::property_tree::read_json("data/result.json", result_tree);
+        std::map<std::string, std::vector<cmri::motifRegion>> result;
+        cmri::deserialize(result_tree,result);
+
+        cmri::common_options_t common_options;
+        common_options.input_file="data/input.fq";
+        common_options.output_path="checkpoint_" + mode;
+        common_options.threads = mode == "process" ? 1 : 2;
+        common_options.chunk_size = 1;
+        cmri::create_output_directory(common_options.output_path, false);
+        cmri::motif_count_options_t motif_count_options;
+        motif_count_options.quality_value=10;
+        motif_count_options.quality_map=30;
+        motif_count_options.checkpoint=4;
+
+        auto run = [&](std::map<std::string, std::vector<cmri::motifRegion>> &motif_map){
+            if (mode == "process") { cmri::process(common_options,motif_count_options, motif_map); }
+            else { cmri::processMultiThreading(common_options,motif_count_options, motif_map); }
+        };
+
+        //the last checkpoint of the full run is left after 4 of the 6 reads, resuming counts the last 2.
+        run(motifs);
+        BOOST_TEST(motifs == result);
+
+        cmri::motif_checkpoint_t checkpoint;
+        auto partial = result;
+        for (auto &item : partial) { for (auto &region : item.second) { region.resetCount(); } }
+        BOOST_TEST(cmri::readCheckpoint(common_options.output_path + "/checkpoint.bin", checkpoint, partial));
+        BOOST_TEST(checkpoint.reads == 4);
+        BOOST_TEST(checkpoint.input_file == common_options.input_file);
+
+        common_options.resume = true;
+        run(resumed);
+        BOOST_TEST(resumed == result);
+
+        //a checkpoint of other regions is rejected and leaves the map untouched.
+        std::map<std::string, std::vector<cmri::motifRegion>> other;
+        other["chr1"];
+        BOOST_TEST(!cmri::readCheckpoint(common_options.output_path + "/checkpoint.bin", checkpoint, other));
+        BOOST_TEST(other.size() == 1);
+    }
+
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,66 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+#include <random>
+#include "../../src/Modules/MotifCount/motifMatcher.h"
+
+
+BOOST_AUTO_TEST_SUITE(motifMatcherTest)
+
+
+    //non overlapping occurrences of every motif, one find per motif.
+    std::vector<std::vector<size_t>> findAll(const std::string &sequence, const std::vector<std::string> &motifs) {
+        std::vector<std::vector<size_t>> result(motifs.size());
+        for (size_t id = 0; id < motifs.size(); id++) {
+            std::string::size_type start = 0;
+            while ((start = sequence.find(motifs[id], start)) != std::string::npos) {
+                result[id].push_back(start);
+                start += motifs[id].size();
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::vector<size_t>> scanAll(const std::string &sequence, const cmri::motifMatcher &matcher) {
+        std::vector<std::vector<size_t>> result(matcher.size());
+        std::vector<size_t> next_start(matcher.size(), 0);
+        matcher.scan(sequence, [&](int32_t id, size_t start) {
+            if (start < next_start[id]) { return; }
+            next_start[id] = start + matcher.getPattern(id).size();
+            result[id].push_back(start);
+        });
+        return result;
+    }
+
+
+    BOOST_AUTO_TEST_CASE(scanTest) {
+
+        std::vector<std::string> motifs = {"CCCTAA", "CCCTGA", "CTAACC", "AA", "AAA", "TTAGGG"};
+        cmri::motifMatcher matcher(motifs);
+
+        std::string sequence = "CCCTAACCCTAACCCTGAAAAAAGTTAGGGTTAGGGCCCTAACCC";
+        BOOST_TEST(scanAll(sequence, matcher) == findAll(sequence, motifs));
+
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> base(0, 3);
+        for (int n = 0; n < 200; n++) {
+            std::string random_sequence;
+            for (int i = 0; i < 300; i++) { random_sequence += "ACGT"[base(generator)]; }
+            BOOST_TEST(scanAll(random_sequence, matcher) == findAll(random_sequence, motifs));
+        }
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(emptyTest) {
+
+        cmri::motifMatcher matcher(std::vector<std::string>{});
+        int hits = 0;
+        matcher.scan("CCCTAA", [&](int32_t, size_t) { hits++; });
+        BOOST_TEST(hits == 0);
+
+    }
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,9 @@
 #include <boost/test/data/test_case.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include "../../src/Modules/MotifCount/motifRegion.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
 
 
 BOOST_AUTO_TEST_SUITE(motifRegionTest)
@@ -62,5 +65,77 @@ BOOST_AUTO_TEST_SUITE(motifRegionTest)
     }
 
 
+    BOOST_AUTO_TEST_CASE(testMotifRegionPartial) {
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+        std::stringstream input_data;
+        input_data << R"({"chr1":[{"start":1,"end":100,"name":"p_telomere","count":0,"total_bases":0,)"
+                   << R"("motifs":{"CCCTAA":0,"TTAGGG":0},"regex":{"(TTAGGG){2}":0},"repeats":{"TTAGGG":0}}]})";
+        boost::property_tree::ptree input_tree;
+        boost::property_tree::read_json(input_data, input_tree);
+        cmri::mapVectorMotifRegion regions;
+        cmri::deserialize(input_tree, regions);
+
+        auto &region = regions["chr1"][0];
+        region.motif_counts.add(1, 30);
+        region.regex_counts.add(0, 20);
+        region.repeat_counts.add(0, 4);
+        region.reads_count = 2;
+        region.total_bases = 100;
+
+        std::string file_name = "testMotifRegionPartial.partial";
+        BOOST_TEST(cmri::writePartial(file_name, cmri::partial_t::motif, regions));
+        std::ifstream file(file_name, std::ios::binary);
+        std::stringstream partial;
+        partial << file.rdbuf();
+        file.close();
+        std::remove(file_name.c_str());
+        std::string bytes = partial.str();
+
+        //merging the same partial twice doubles every count.
+        cmri::mapVectorMotifRegion merged;
+        for (int i = 0; i < 2; i++) {
+            std::stringstream in(bytes);
+            cmri::partial_t kind;
+            BOOST_TEST(cmri::readPartialKind(in, kind));
+            BOOST_TEST((kind == cmri::partial_t::motif));
+            BOOST_TEST(cmri::mergePartial(in, merged));
+        }
+        auto &result = merged["chr1"][0];
+        BOOST_TEST(result.name == "p_telomere");
+        BOOST_TEST(result.motifs == region.motifs);
+        BOOST_TEST(result.reads_count == 4);
+        BOOST_TEST(result.total_bases == 200);
+        BOOST_TEST(result.motif_counts.get(1, 30) == 2);
+        BOOST_TEST(result.regex_counts.get(0, 20) == 2);
+        BOOST_TEST(result.repeat_counts.get(0, 4) == 2);
+
+        //regions with other patterns are not merged.
+        auto other = merged;
+        other["chr1"][0].regex.clear();
+        other["chr1"][0].regex_counts.resize(0);
+        std::stringstream in(bytes);
+        cmri::partial_t kind;
+        cmri::readPartialKind(in, kind);
+        BOOST_TEST(!cmri::mergePartial(in, other));
+
+        //nor regions counted with other settings.
+        auto other_settings = [&](std::function<void(cmri::motifRegion &)> change) {
+            auto changed = merged;
+            change(changed["chr1"][0]);
+            std::stringstream settings_in(bytes);
+            cmri::readPartialKind(settings_in, kind);
+            return !cmri::mergePartial(settings_in, changed);
+        };
+        BOOST_TEST(other_settings([](cmri::motifRegion &r) { r.distance = cmri::distanceType::edit; }));
+        BOOST_TEST(other_settings([](cmri::motifRegion &r) { r.max_distance = 2; }));
+        BOOST_TEST(other_settings([](cmri::motifRegion &r) { r.min_repeats = 5; }));
+
+        //truncated files are rejected.
+        std::stringstream truncated(bytes.substr(0, bytes.size() - 10));
+        cmri::readPartialKind(truncated, kind);
+        cmri::mapVectorMotifRegion empty;
+        BOOST_TEST(!cmri::mergePartial(truncated, empty));
+
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/test_case.hpp>
+#include "orderedPipeline.h"
+#include <atomic>
+#include <chrono>
+
+
+BOOST_AUTO_TEST_SUITE(orderedPipelineTest)
+
+    //later items finish first: item i sleeps longer the smaller i % 7 is.
+    void mapDelay(int item) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100 * (7 - item % 7)));
+    }
+
+    int sample_threads[] = {1, 2, 4};
+
+    BOOST_DATA_TEST_CASE(orderedPipelineOrderTest, boost::unit_test::data::make(sample_threads), threads) {
+
+        const int size = 500;
+        int next_item = 0;
+        auto next = [&](int &item) {
+            if (next_item == size) { return false; }
+            item = next_item++;
+            return true;
+        };
+        //every third item has no result.
+        auto map = [](int, const int &item, int &result) {
+            mapDelay(item);
+            result = 10 * item;
+            return item % 3 != 0;
+        };
+        std::vector<int> written;
+        auto write = [&](int &result) { written.push_back(result); };
+
+        const uint64_t count = cmri::orderedPipeline<int, int>(threads, 8, next, map, write);
+        BOOST_TEST(count == size);
+
+        std::vector<int> expected;
+        for (int item = 0; item < size; item++) { if (item % 3 != 0) { expected.push_back(10 * item); } }
+        BOOST_TEST(written == expected);
+
+    }
+
+    BOOST_AUTO_TEST_CASE(orderedPipelineBoundTest) {
+
+        //reads not written yet never exceed max_pending, even when the first item is the slowest one.
+        const uint64_t max_pending = 5;
+        std::atomic<int> read(0);
+        std::atomic<int> written(0);
+        std::atomic<int> max_in_flight(0);
+        auto next = [&](int &item) {
+            if (read == 200) { return false; }
+            item = read++;
+            max_in_flight = std::max(max_in_flight.load(), read - written);
+            return true;
+        };
+        auto map = [](int, const int &item, int &result) {
+            if (item % 50 == 0) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+            result = item;
+            return true;
+        };
+        int last = -1;
+        bool ordered = true;
+        auto write = [&](int &result) {
+            ordered = ordered && result == last + 1;
+            last = result;
+            written++;
+        };
+
+        const uint64_t count = cmri::orderedPipeline<int, int>(4, max_pending, next, map, write);
+        BOOST_TEST(count == 200);
+        BOOST_TEST(ordered);
+        BOOST_TEST(written == 200);
+        BOOST_TEST(max_in_flight <= static_cast<int>(max_pending));
+        BOOST_TEST(max_in_flight > 1);
+
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -34,4 +34,142 @@ BOOST_AUTO_TEST_SUITE(sequenceReaderTest)
     }
 
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+    BOOST_DATA_TEST_CASE(readerBatchTest,
+                         boost::unit_test::data::make(sample_file_name), file_name) {
+
+        cmri::sequenceReader item_reader(file_name,10,30);
+        std::vector<std::string> expected;
+        cmri::read_item_t item;
+        while(item_reader.get(item)){
+            if(item.valid){ expected.push_back(item.sequence); }
+        }
+        item_reader.close();
+
+        //small batches so the pool recycles them several times.
+        cmri::readBatchPool batch_pool(3);
+        cmri::sequenceReader reader(file_name,10,30);
+        std::vector<std::string> sequences;
+        while(true){
+            auto batch = batch_pool.acquire();
+            if(reader.get(*batch) == 0){
+                batch_pool.release(batch);
+                break;
+            }
+            BOOST_TEST(batch->size <= batch->capacity());
+            for(const auto &read : *batch){
+                BOOST_TEST(read.valid);
+                sequences.push_back(read.sequence);
+            }
+            batch_pool.release(batch);
+        }
+        reader.close();
+
+        BOOST_TEST(sequences == expected, boost::test_tools::per_element());
+        BOOST_TEST(reader.getCount() == item_reader.getCount());
+        BOOST_TEST(batch_pool.size() == 1);
+
+    }
+
+    BOOST_DATA_TEST_CASE(readerLazyQualityTest,
+                         boost::unit_test::data::make(sample_file_name), file_name) {
+
+        cmri::sequenceReader decoded_reader(file_name,10,30);
+        cmri::sequenceReader raw_reader(file_name,10,30);
+        raw_reader.setQualityDecoding(false);
+
+        cmri::read_item_t decoded, raw;
+        while(decoded_reader.get(decoded)){
+            BOOST_TEST(raw_reader.get(raw));
+            //same reads and the same qv_fail decisions, without per base qualities.
+            BOOST_TEST(raw.sequence == decoded.sequence);
+            BOOST_TEST(raw.name == decoded.name);
+            BOOST_TEST(raw.qvalue.empty());
+            BOOST_TEST(raw.qsum.empty());
+            BOOST_TEST(raw.raw_quality == decoded.raw_quality);
+            raw.decodeQuality();
+            BOOST_TEST(raw.qvalue == decoded.qvalue);
+            BOOST_TEST(raw.qsum == decoded.qsum);
+        }
+        BOOST_TEST(!raw_reader.get(raw));
+
+        decoded_reader.close();
+        raw_reader.close();
+
+    }
+
+
+    BOOST_DATA_TEST_CASE(readerProgressTest,
+                         boost::unit_test::data::make(sample_file_name), file_name) {
+
+        cmri::sequenceReader reader(file_name,10,30);
+        cmri::read_item_t item;
+        while(reader.get(item)){}
+
+        //the whole input has been consumed (bgzf stops before the empty EOF block).
+        BOOST_TEST(reader.getProgress() > 0.9);
+        BOOST_TEST(reader.getProgress() <= 1.0);
+        BOOST_TEST(reader.getTotalReads() == reader.getCount());
+        reader.close();
+
+    }
+
+
+    std::string sample_seek_file_name[] = {"data/input.fq", "data/input.fq.gz", "data/input.bam"};
+
+    BOOST_DATA_TEST_CASE(readerSeekTest,
+                         boost::unit_test::data::make(sample_seek_file_name), file_name) {
+
+        cmri::sequenceReader reader(file_name,10,30);
+        cmri::read_item_t item;
+        std::vector<std::string> sequences;
+        while(reader.get(item)){ sequences.push_back(item.sequence); }
+        reader.close();
+
+        //stop half way, a new reader continues at the saved position.
+        const int half = static_cast<int>(sequences.size() / 2);
+        cmri::sequenceReader first_reader(file_name,10,30);
+        for(int i = 0; i < half; i++){ first_reader.get(item); }
+        const int64_t position = first_reader.tell();
+        first_reader.close();
+        BOOST_TEST(position >= 0);
+
+        cmri::sequenceReader second_reader(file_name,10,30);
+        BOOST_TEST(second_reader.seek(position, half));
+        std::vector<std::string> rest;
+        while(second_reader.get(item)){ rest.push_back(item.sequence); }
+        second_reader.close();
+
+        BOOST_TEST(second_reader.getCount() == static_cast<int>(sequences.size()));
+        BOOST_REQUIRE(rest.size() == sequences.size() - half);
+        BOOST_TEST(std::equal(rest.begin(), rest.end(), sequences.begin() + half));
+
+    }
+
+
+    std::string sample_shard_file_name[] = {"data/input.fq", "data/input_bgzf.fq.gz", "data/input.bam"};
+
+    BOOST_DATA_TEST_CASE(readerShardTest,
+                         boost::unit_test::data::make(sample_shard_file_name), file_name) {
+
+        cmri::sequenceReader reader(file_name,10,30);
+        cmri::read_item_t item;
+        std::vector<std::string> sequences;
+        while(reader.get(item)){ if(item.valid){ sequences.push_back(item.sequence); } }
+        reader.close();
+
+        //shards read in order return every read once, whatever the number of shards.
+        for(int count = 1; count <= 12; count++){
+            std::vector<std::string> shard_sequences;
+            for(int index = 0; index < count; index++){
+                cmri::sequenceReader shard_reader(file_name,10,30);
+                shard_reader.setShard(index, count);
+                while(shard_reader.get(item)){ if(item.valid){ shard_sequences.push_back(item.sequence); } }
+                shard_reader.close();
+            }
+            BOOST_TEST(shard_sequences == sequences, "shards: " << count);
+        }
+
+    }
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include "../../src/Modules/MotifCount/tandemRepeatMatcher.h"
+
+
+BOOST_AUTO_TEST_SUITE(tandemRepeatMatcherTest)
+
+
+    typedef std::tuple<int32_t, size_t, uint32_t> run_t; //unit id, start, copies
+
+    std::vector<run_t> scanAll(const std::string &sequence, const cmri::tandemRepeatMatcher &matcher) {
+        std::vector<run_t> result;
+        matcher.scan(sequence, [&](int32_t id, size_t start, uint32_t units) { result.emplace_back(id, start, units); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    //maximal chains of copies one unit length apart, of the chains of a unit overlapping each other the one with most
+    //copies (the first on ties).
+    std::vector<run_t> reference(const std::string &sequence, const std::vector<std::string> &units,
+                                 uint32_t min_units) {
+        std::vector<run_t> result;
+        for (size_t id = 0; id < units.size(); id++) {
+            const size_t length = units[id].size();
+            auto copy = [&](size_t i) { return i + length <= sequence.size() && sequence.compare(i, length, units[id]) == 0; };
+            std::vector<std::pair<size_t, uint32_t>> chains; //start, copies
+            for (size_t i = 0; i + length <= sequence.size(); i++) {
+                if (!copy(i) || (i >= length && copy(i - length))) { continue; }
+                uint32_t copies = 0;
+                while (copy(i + copies * length)) { copies++; }
+                chains.emplace_back(i, copies);
+            }
+            size_t c = 0;
+            while (c < chains.size()) {
+                auto best = chains[c++];
+                while (c < chains.size() && chains[c].first < best.first + best.second * length) {
+                    if (chains[c].second > best.second) { best = chains[c]; }
+                    c++;
+                }
+                if (best.second >= min_units) { result.emplace_back(id, best.first, best.second); }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+
+    BOOST_AUTO_TEST_CASE(telomereTest) {
+
+        std::string sequence = "ACTTAGGGTTAGGGTTAGGGTCAGGGTTAGGGTTAGGGNCCCTAACCCTAA";
+        cmri::tandemRepeatMatcher matcher({"TTAGGG", "TCAGGG", "CCCTAA"}, 1);
+        std::vector<run_t> expected = {{0, 2, 3}, {0, 26, 2}, {1, 20, 1}, {2, 39, 2}};
+        BOOST_TEST((scanAll(sequence, matcher) == expected));
+
+        cmri::tandemRepeatMatcher long_runs({"TTAGGG", "TCAGGG", "CCCTAA"}, 3);
+        expected = {{0, 2, 3}};
+        BOOST_TEST((scanAll(sequence, long_runs) == expected));
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(periodicUnitTest) {
+
+        //copies of a unit overlapping each other give runs in several phases, the longest one is reported.
+        cmri::tandemRepeatMatcher matcher({"AA", "ATA"}, 1);
+        std::vector<run_t> expected = {{0, 0, 3}, {0, 7, 1}, {1, 5, 1}};
+        BOOST_TEST((scanAll("AAAAAATAA", matcher) == expected));
+
+        //ATA at 0, 2 and 5: the run at 0 does not hide the two copies at 2 and 5.
+        cmri::tandemRepeatMatcher pairs({"ATA"}, 2);
+        expected = {{0, 2, 2}};
+        BOOST_TEST((scanAll("ATATAATA", pairs) == expected));
+
+        //phases 0 and 1 of AAAAAAA both hold 3 copies, the first one is reported.
+        expected = {{0, 0, 3}};
+        BOOST_TEST((scanAll("AAAAAAA", matcher) == expected));
+        expected = {{0, 1, 4}};
+        BOOST_TEST((scanAll("CAAAAAAAA", matcher) == expected));
+
+    }
+
+
+    BOOST_AUTO_TEST_CASE(randomTest) {
+
+        std::vector<std::vector<std::string>> unit_sets = {
+                {"TTAGGG", "TCAGGG", "CCCTAA"},
+                {"A", "AG", "AGG", "TTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAGGGTTAGGG"},
+                {"AA", "ATA", "ATAT", "TTAGGGTTA"}};
+
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> base(0, 3);
+        for (auto &units : unit_sets) {
+            for (uint32_t min_units : {1, 2, 4}) {
+                cmri::tandemRepeatMatcher matcher(units, min_units);
+                for (int n = 0; n < 100; n++) {
+                    std::string sequence;
+                    for (int i = 0; i < 30; i++) {
+                        if (base(generator) == 0) {
+                            auto copies = generator() % 6;
+                            for (size_t c = 0; c < copies; c++) { sequence += units[generator() % units.size()]; }
+                        } else {
+                            sequence += "ACGTN"[generator() % 5];
+                        }
+                    }
+                    BOOST_TEST((scanAll(sequence, matcher) == reference(sequence, units, min_units)));
+                }
+            }
+        }
+
+    }
+
+
+BOOST_AUTO_TEST_SUITE_END()
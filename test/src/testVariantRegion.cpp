@@ -62,5 +62,37 @@ BOOST_AUTO_TEST_SUITE(variantRegionTest)
     }
 
 
+    BOOST_AUTO_TEST_CASE(testVariantRegionPartial) {
+
+        cmri::variantRegion region;
+        region.start = 9995;
+        region.end = 11005;
+        region.name = "p_telomere";
+        region.total_bases = 3;
+        region.mutations["C>A"]["sample1"] = 2;
+        region.mutations["C>T"]["sample1"] = 1;
+
+        std::stringstream partial;
+        region.writePartial(partial);
+        cmri::variantRegion restored;
+        BOOST_TEST(restored.readPartial(partial));
+        BOOST_TEST((restored == region));
+        BOOST_TEST((restored.mutations == region.mutations));
+
+        //counts of other samples and mutations are added.
+        cmri::variantRegion lane;
+        lane.start = 9995;
+        lane.end = 11005;
+        lane.name = "p_telomere";
+        lane.total_bases = 2;
+        lane.mutations["C>A"]["sample1"] = 1;
+        lane.mutations["C>A"]["sample2"] = 1;
+        restored += lane;
+        BOOST_TEST(restored.total_bases == 5);
+        BOOST_TEST(restored.mutations["C>A"]["sample1"] == 3);
+        BOOST_TEST(restored.mutations["C>A"]["sample2"] == 1);
+        BOOST_TEST(restored.mutations["C>T"]["sample1"] == 1);
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+    }
+
+BOOST_AUTO_TEST_SUITE_END()